@@ -0,0 +1,194 @@
+#include "xeno-pal/xeno-pal.hpp"
+#include "xeno-pal/xeno-pal-fiber.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Deep fork/join recursion on pal::ThreadPool against pal::FiberJobSystem.
+//
+//   quadtree: terrain-LOD style refinement, every node forks four children
+//             and waits for them
+//   bvh:      median-split build over random points, two children per node
+//             after an nth_element partition
+//
+// ThreadPool waits through TaskGroup, which runs other tasks on the waiting
+// thread's stack; the fiber system parks the waiting job instead.
+
+namespace
+{
+    constexpr int QuadtreeDepth = 9;
+    constexpr size_t BvhPoints = 1 << 20;
+    constexpr size_t BvhLeafSize = 64;
+    constexpr int Runs = 5;
+
+    float leafWork(uint32_t seed)
+    {
+        // Stand-in for evaluating a terrain patch
+        float value = 0.0f;
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            value += static_cast<float>(seed >> 8) * (1.0f / 16777216.0f);
+        }
+        return value;
+    }
+
+    void quadtreePool(xeno::pal::ThreadPool &pool, int depth, uint32_t seed, std::atomic<uint64_t> &leaves)
+    {
+        if (depth == 0)
+        {
+            leaves.fetch_add(leafWork(seed) > 0.0f ? 1 : 0, std::memory_order_relaxed);
+            return;
+        }
+        xeno::pal::TaskGroup group(pool);
+        for (uint32_t child = 0; child < 4; ++child)
+        {
+            group.run([&pool, depth, seed, child, &leaves]()
+                      { quadtreePool(pool, depth - 1, seed * 4 + child, leaves); });
+        }
+        group.wait();
+    }
+
+    void quadtreeFiber(xeno::pal::FiberJobSystem &jobs, int depth, uint32_t seed, std::atomic<uint64_t> &leaves)
+    {
+        if (depth == 0)
+        {
+            leaves.fetch_add(leafWork(seed) > 0.0f ? 1 : 0, std::memory_order_relaxed);
+            return;
+        }
+        xeno::pal::JobCounter children;
+        for (uint32_t child = 0; child < 4; ++child)
+        {
+            jobs.run([&jobs, depth, seed, child, &leaves]()
+                     { quadtreeFiber(jobs, depth - 1, seed * 4 + child, leaves); },
+                     &children);
+        }
+        jobs.waitFor(children);
+    }
+
+    struct Point
+    {
+        float x, y, z;
+    };
+
+    float axisOf(const Point &point, int axis)
+    {
+        return axis == 0 ? point.x : (axis == 1 ? point.y : point.z);
+    }
+
+    void splitMedian(Point *first, Point *last, int axis)
+    {
+        Point *middle = first + (last - first) / 2;
+        std::nth_element(first, middle, last, [axis](const Point &a, const Point &b)
+                         { return axisOf(a, axis) < axisOf(b, axis); });
+    }
+
+    void bvhPool(xeno::pal::ThreadPool &pool, Point *first, Point *last, int axis)
+    {
+        if (static_cast<size_t>(last - first) <= BvhLeafSize)
+        {
+            return;
+        }
+        splitMedian(first, last, axis);
+        Point *middle = first + (last - first) / 2;
+        xeno::pal::TaskGroup group(pool);
+        group.run([&pool, first, middle, axis]()
+                  { bvhPool(pool, first, middle, (axis + 1) % 3); });
+        group.run([&pool, middle, last, axis]()
+                  { bvhPool(pool, middle, last, (axis + 1) % 3); });
+        group.wait();
+    }
+
+    void bvhFiber(xeno::pal::FiberJobSystem &jobs, Point *first, Point *last, int axis)
+    {
+        if (static_cast<size_t>(last - first) <= BvhLeafSize)
+        {
+            return;
+        }
+        splitMedian(first, last, axis);
+        Point *middle = first + (last - first) / 2;
+        xeno::pal::JobCounter children;
+        jobs.run([&jobs, first, middle, axis]()
+                 { bvhFiber(jobs, first, middle, (axis + 1) % 3); },
+                 &children);
+        jobs.run([&jobs, middle, last, axis]()
+                 { bvhFiber(jobs, middle, last, (axis + 1) % 3); },
+                 &children);
+        jobs.waitFor(children);
+    }
+
+    template <typename Body>
+    double bestOfMs(Body &&body)
+    {
+        double best = 1e30;
+        for (int run = 0; run < Runs; ++run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    size_t maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0)
+    {
+        maxThreads = 1;
+    }
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::vector<Point> source(BvhPoints);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+    for (Point &point : source)
+    {
+        point = {coordinate(rng), coordinate(rng), coordinate(rng)};
+    }
+    std::vector<Point> points;
+
+    std::printf("%-8s %16s %16s %16s %16s %8s\n", "threads", "pool quadtree", "fiber quadtree", "pool bvh", "fiber bvh", "fibers");
+    for (size_t threads : threadCounts)
+    {
+        xeno::pal::ThreadPool pool(threads);
+        xeno::pal::FiberJobSystemConfig config;
+        config.workerThreads = threads;
+        xeno::pal::FiberJobSystem jobs(config);
+        std::atomic<uint64_t> leaves{0};
+
+        double poolQuadtree = bestOfMs([&]()
+                                       { quadtreePool(pool, QuadtreeDepth, 1, leaves); });
+        double fiberQuadtree = bestOfMs([&]()
+                                        {
+            xeno::pal::JobCounter root;
+            jobs.run([&]() { quadtreeFiber(jobs, QuadtreeDepth, 1, leaves); }, &root);
+            jobs.waitFor(root); });
+        double poolBvh = bestOfMs([&]()
+                                  {
+            points = source;
+            bvhPool(pool, points.data(), points.data() + points.size(), 0); });
+        double fiberBvh = bestOfMs([&]()
+                                   {
+            points = source;
+            xeno::pal::JobCounter root;
+            jobs.run([&]() { bvhFiber(jobs, points.data(), points.data() + points.size(), 0); }, &root);
+            jobs.waitFor(root); });
+
+        std::printf("%-8zu %13.2f ms %13.2f ms %13.2f ms %13.2f ms %8zu\n", threads, poolQuadtree, fiberQuadtree, poolBvh, fiberBvh,
+                    jobs.fiberCount());
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "xeno-pal/xeno-pal-parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Serial versus parallelFor/parallelReduce/parallelExclusiveScan on a
+// 4096 x 4096 terrain grid, using the same vertex/index layout as
+// generateTerrain in the Vulkan demos.
+
+namespace
+{
+    constexpr size_t GridSize = 4096;
+    constexpr int Repetitions = 3;
+
+    struct Vertex
+    {
+        float pos[3];
+        float texCoord[2];
+    };
+
+    float heightAt(size_t x, size_t z)
+    {
+        return std::sin(x * 0.01f) * std::cos(z * 0.013f) * 5.0f;
+    }
+
+    void writeVertexRow(std::vector<Vertex> &vertices, size_t z)
+    {
+        for (size_t x = 0; x < GridSize; ++x)
+        {
+            Vertex &vertex = vertices[z * GridSize + x];
+            vertex.pos[0] = x - GridSize / 2.0f;
+            vertex.pos[1] = heightAt(x, z);
+            vertex.pos[2] = z - GridSize / 2.0f;
+            vertex.texCoord[0] = static_cast<float>(x) / (GridSize - 1);
+            vertex.texCoord[1] = static_cast<float>(z) / (GridSize - 1);
+        }
+    }
+
+    void writeIndexRow(std::vector<uint32_t> &indices, size_t z)
+    {
+        uint32_t *out = &indices[z * (GridSize - 1) * 6];
+        for (size_t x = 0; x < GridSize - 1; ++x)
+        {
+            uint32_t topLeft = static_cast<uint32_t>(z * GridSize + x);
+            uint32_t topRight = topLeft + 1;
+            uint32_t bottomLeft = static_cast<uint32_t>((z + 1) * GridSize + x);
+            uint32_t bottomRight = bottomLeft + 1;
+            *out++ = topLeft;
+            *out++ = bottomLeft;
+            *out++ = topRight;
+            *out++ = topRight;
+            *out++ = bottomLeft;
+            *out++ = bottomRight;
+        }
+    }
+
+    // Best of a few runs, in milliseconds
+    template <typename F>
+    double timeMs(F &&f)
+    {
+        double best = 1e30;
+        for (int i = 0; i < Repetitions; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    void report(const char *name, double serial, double parallel)
+    {
+        std::printf("%-22s %10.2f ms %10.2f ms %8.2fx\n", name, serial, parallel, serial / parallel);
+    }
+}
+
+int main()
+{
+    xeno::pal::ThreadPool pool;
+    std::printf("%zu x %zu terrain grid, %zu workers\n\n", GridSize, GridSize, pool.size());
+    std::printf("%-22s %13s %13s %9s\n", "kernel", "serial", "parallel", "speedup");
+
+    std::vector<Vertex> vertices(GridSize * GridSize);
+    std::vector<uint32_t> indices((GridSize - 1) * (GridSize - 1) * 6);
+
+    report("vertices",
+           timeMs([&]()
+                  { for (size_t z = 0; z < GridSize; ++z) writeVertexRow(vertices, z); }),
+           timeMs([&]()
+                  { xeno::pal::parallelFor(pool, 0, GridSize, [&](size_t first, size_t last)
+                                           { for (size_t z = first; z < last; ++z) writeVertexRow(vertices, z); }); }));
+
+    report("indices",
+           timeMs([&]()
+                  { for (size_t z = 0; z < GridSize - 1; ++z) writeIndexRow(indices, z); }),
+           timeMs([&]()
+                  { xeno::pal::parallelFor(pool, 0, GridSize - 1, [&](size_t first, size_t last)
+                                           { for (size_t z = first; z < last; ++z) writeIndexRow(indices, z); }); }));
+
+    volatile float sink = 0.0f;
+    report("max height (reduce)",
+           timeMs([&]()
+                  {
+                float highest = -1e30f;
+                for (const Vertex &vertex : vertices)
+                {
+                    highest = std::max(highest, vertex.pos[1]);
+                }
+                sink = highest; }),
+           timeMs([&]()
+                  { sink = xeno::pal::parallelReduce<float>(
+                        pool, 0, vertices.size(), -1e30f,
+                        [&](size_t first, size_t last)
+                        {
+                            float highest = -1e30f;
+                            for (size_t i = first; i < last; ++i)
+                            {
+                                highest = std::max(highest, vertices[i].pos[1]);
+                            }
+                            return highest;
+                        },
+                        [](float a, float b)
+                        { return std::max(a, b); }); }));
+
+    // Index offsets for a compacted mesh: cells below the waterline emit no triangles
+    std::vector<uint32_t> cellIndexCounts(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        cellIndexCounts[i] = vertices[i].pos[1] > -2.5f ? 6 : 0;
+    }
+    std::vector<uint32_t> offsets(cellIndexCounts.size());
+    auto add = [](uint32_t a, uint32_t b)
+    { return a + b; };
+    report("index offsets (scan)",
+           timeMs([&]()
+                  {
+                uint32_t running = 0;
+                for (size_t i = 0; i < cellIndexCounts.size(); ++i)
+                {
+                    offsets[i] = running;
+                    running += cellIndexCounts[i];
+                } }),
+           timeMs([&]()
+                  { xeno::pal::parallelExclusiveScan(pool, cellIndexCounts.begin(), cellIndexCounts.end(), offsets.begin(), 0u, add); }));
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "xeno-pal/xeno-pal-workqueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Handoff throughput of the lock-free rings against a mutex-guarded
+// std::deque bounded to the same capacity.
+//
+//   spsc: one producer, one consumer (render command / input event shape)
+//   mpmc: N producers, N consumers (job injection / logging shape)
+//
+// Every side spins with yield when the queue is full or empty, so the
+// numbers measure the queues rather than wakeup latency.
+
+namespace
+{
+    constexpr uint64_t ItemCount = 1 << 22;
+    constexpr size_t Capacity = 1024;
+
+    class MutexQueue
+    {
+    public:
+        explicit MutexQueue(size_t capacity) : m_capacity(capacity) {}
+
+        bool tryPush(uint64_t item)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_items.size() >= m_capacity)
+            {
+                return false;
+            }
+            m_items.push_back(item);
+            return true;
+        }
+
+        bool tryPop(uint64_t &out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_items.empty())
+            {
+                return false;
+            }
+            out = m_items.front();
+            m_items.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::deque<uint64_t> m_items;
+        size_t m_capacity;
+    };
+
+    // Returns millions of items handed over per second
+    template <typename Queue>
+    double handoff(size_t producers, size_t consumers)
+    {
+        Queue queue(Capacity);
+        const uint64_t perProducer = ItemCount / producers;
+        const uint64_t total = perProducer * producers;
+        std::atomic<uint64_t> popped{0};
+        std::atomic<uint64_t> checksum{0};
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&queue, perProducer]()
+                                 {
+                for (uint64_t i = 0; i < perProducer; ++i)
+                {
+                    while (!queue.tryPush(i))
+                    {
+                        std::this_thread::yield();
+                    }
+                } });
+        }
+        for (size_t c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&queue, &popped, &checksum, total]()
+                                 {
+                uint64_t sum = 0;
+                while (popped.load(std::memory_order_relaxed) < total)
+                {
+                    uint64_t value = 0;
+                    if (!queue.tryPop(value))
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    sum += value;
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                }
+                checksum.fetch_add(sum); });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (checksum.load() != producers * (perProducer * (perProducer - 1) / 2))
+        {
+            std::printf("checksum mismatch\n");
+        }
+        return total / elapsed.count() / 1e6;
+    }
+}
+
+int main()
+{
+    size_t maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0)
+    {
+        maxThreads = 1;
+    }
+
+    std::printf("%-12s %14s %14s\n", "shape", "mutex+deque", "lock-free");
+    std::printf("%-12s %10.2f M/s %10.2f M/s\n", "spsc 1:1",
+                handoff<MutexQueue>(1, 1),
+                handoff<xeno::pal::SpscQueue<uint64_t>>(1, 1));
+
+    std::vector<size_t> sideCounts;
+    for (size_t side = 1; side * 2 <= maxThreads; side *= 2)
+    {
+        sideCounts.push_back(side);
+    }
+    if (sideCounts.empty())
+    {
+        sideCounts.push_back(1);
+    }
+    for (size_t side : sideCounts)
+    {
+        char shape[32];
+        std::snprintf(shape, sizeof(shape), "mpmc %zu:%zu", side, side);
+        std::printf("%-12s %10.2f M/s %10.2f M/s\n", shape,
+                    handoff<MutexQueue>(side, side),
+                    handoff<xeno::pal::MpmcQueue<uint64_t>>(side, side));
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include "xeno-pal/xeno-pal.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Measures task throughput of pal::ThreadPool against the single
+// mutex-and-condition-variable queue it replaced, for 1..N worker threads.
+//
+//   external: one thread submits every task (injection queue path)
+//   fan-out:  a handful of root tasks each enqueue children from inside
+//             the pool (owner deque + stealing path)
+//   bursts:   frame-sized batches of tiny tasks with idle gaps between them,
+//             comparing workers that park at once against the default
+//             spin-then-park policy
+
+namespace
+{
+    constexpr int TaskCount = 1 << 20;
+    constexpr int FanOutRoots = 64;
+
+    // The pre-work-stealing ThreadPool, kept here as the baseline
+    class MutexQueuePool
+    {
+    public:
+        explicit MutexQueuePool(size_t numThreads)
+        {
+            for (size_t i = 0; i < numThreads; ++i)
+            {
+                threads_.emplace_back([this]()
+                                      {
+                    for (;;)
+                    {
+                        std::function<void()> task;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex_);
+                            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                            if (stopping_ && tasks_.empty())
+                            {
+                                return;
+                            }
+                            task = std::move(tasks_.front());
+                            tasks_.pop();
+                        }
+                        task();
+                    } });
+            }
+        }
+
+        ~MutexQueuePool()
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            condition_.notify_all();
+            for (std::thread &thread : threads_)
+            {
+                thread.join();
+            }
+        }
+
+        template <typename F>
+        void enqueue(F &&f)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            tasks_.emplace(std::forward<F>(f));
+            condition_.notify_one();
+        }
+
+    private:
+        std::vector<std::thread> threads_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool stopping_ = false;
+    };
+
+    void waitFor(const std::atomic<int> &counter, int target)
+    {
+        while (counter.load(std::memory_order_acquire) < target)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    template <typename Pool>
+    double externalSubmission(size_t threads)
+    {
+        Pool pool(threads);
+        std::atomic<int> done{0};
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < TaskCount; ++i)
+        {
+            pool.enqueue([&done]()
+                         { done.fetch_add(1, std::memory_order_release); });
+        }
+        waitFor(done, TaskCount);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return TaskCount / elapsed.count();
+    }
+
+    template <typename Pool>
+    double fanOut(size_t threads)
+    {
+        Pool pool(threads);
+        std::atomic<int> done{0};
+        const int childrenPerRoot = TaskCount / FanOutRoots;
+        auto start = std::chrono::steady_clock::now();
+        for (int root = 0; root < FanOutRoots; ++root)
+        {
+            pool.enqueue([&pool, &done, childrenPerRoot]()
+                         {
+                for (int i = 0; i < childrenPerRoot; ++i)
+                {
+                    pool.enqueue([&done]() { done.fetch_add(1, std::memory_order_release); });
+                } });
+        }
+        waitFor(done, FanOutRoots * childrenPerRoot);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return FanOutRoots * childrenPerRoot / elapsed.count();
+    }
+
+    constexpr int Bursts = 2000;
+    constexpr int TasksPerBurst = 64;
+
+    struct BurstResult
+    {
+        double microsPerBurst;
+        xeno::pal::IdleStats idle;
+    };
+
+    BurstResult bursts(size_t threads, xeno::pal::IdlePolicy policy)
+    {
+        xeno::pal::ThreadPoolConfig config;
+        config.workerThreads = threads;
+        config.idle = policy;
+        xeno::pal::ThreadPool pool(config);
+
+        std::chrono::duration<double, std::micro> busy{0};
+        for (int burst = 0; burst < Bursts; ++burst)
+        {
+            // Stand-in for the rest of the frame, long enough for workers to go idle
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+            std::atomic<int> done{0};
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < TasksPerBurst; ++i)
+            {
+                pool.dispatch([&done]()
+                              { done.fetch_add(1, std::memory_order_release); });
+            }
+            waitFor(done, TasksPerBurst);
+            busy += std::chrono::steady_clock::now() - start;
+        }
+        return {busy.count() / Bursts, pool.idleStats()};
+    }
+}
+
+int main()
+{
+    size_t maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0)
+    {
+        maxThreads = 1;
+    }
+
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::printf("%-8s %18s %18s %18s %18s\n", "threads", "mutex external", "steal external", "mutex fan-out", "steal fan-out");
+    for (size_t threads : threadCounts)
+    {
+        std::printf("%-8zu %14.2f M/s %14.2f M/s %14.2f M/s %14.2f M/s\n", threads,
+                    externalSubmission<MutexQueuePool>(threads) / 1e6,
+                    externalSubmission<xeno::pal::ThreadPool>(threads) / 1e6,
+                    fanOut<MutexQueuePool>(threads) / 1e6,
+                    fanOut<xeno::pal::ThreadPool>(threads) / 1e6);
+    }
+
+    xeno::pal::IdlePolicy park;
+    park.spinRounds = 0;
+    park.yieldRounds = 0;
+    std::printf("\n%-8s %-8s %14s %12s %10s %10s %14s\n", "threads", "idle", "us/burst", "spin ms", "spin hits", "parks", "saved ms");
+    for (size_t threads : threadCounts)
+    {
+        const std::pair<const char *, xeno::pal::IdlePolicy> policies[] = {{"park", park}, {"spin", xeno::pal::IdlePolicy{}}};
+        for (const auto &policy : policies)
+        {
+            BurstResult result = bursts(threads, policy.second);
+            std::printf("%-8zu %-8s %14.2f %12.2f %10llu %10llu %14.2f\n", threads, policy.first, result.microsPerBurst,
+                        result.idle.spinMs(), static_cast<unsigned long long>(result.idle.spinHits),
+                        static_cast<unsigned long long>(result.idle.parks), result.idle.savedLatencyMs());
+        }
+    }
+    return 0;
+}
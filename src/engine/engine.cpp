@@ -1,8 +1,46 @@
 #include "engine.hpp"
+#include "xeno-pal-topology.hpp"
+#include <iostream>
 
 namespace xeno
 {
-    Engine::Engine(EngineConfig config) : window(config.width, config.height, config.title), config(config)
+    namespace
+    {
+        xeno::pal::Arena::VirtualConfig frameArenaConfig(const EngineConfig &config)
+        {
+            xeno::pal::Arena::VirtualConfig arenaConfig;
+            arenaConfig.reserveSize = config.frameArenaSize;
+            // Keep whatever the busiest frame committed so steady-state frames
+            // never go back to the OS.
+            arenaConfig.retainOnReset = config.frameArenaSize;
+            arenaConfig.tag = xeno::pal::MemoryTag::Frame;
+            return arenaConfig;
+        }
+
+        xeno::pal::ThreadPoolConfig threadPoolConfig(const EngineConfig &config)
+        {
+            xeno::pal::ThreadPoolConfig poolConfig;
+            poolConfig.workerThreads = config.workerThreads;
+            if (poolConfig.workerThreads == 0)
+            {
+                // SMT siblings share execution units, so they do not add workers
+                size_t cores = xeno::pal::CpuTopology::get().cores.size();
+                poolConfig.workerThreads = cores > 1 ? cores - 1 : 1;
+            }
+            if (config.pinThreads)
+            {
+                poolConfig.affinity = xeno::pal::WorkerAffinity::PhysicalCores;
+                poolConfig.reserveMainThreadCore = true;
+            }
+            poolConfig.ioThreads = config.ioThreads;
+            return poolConfig;
+        }
+    }
+
+    Engine::Engine(EngineConfig config)
+        : window(config.width, config.height, config.title), config(config),
+          frameArenas(xeno::vulkan::VulkanRenderer::MAX_FRAMES_IN_FLIGHT, frameArenaConfig(config)),
+          workers(threadPoolConfig(config)), taskGraph(workers)
     {
         // Initialize renderer after window is created and GLFW is set up
         renderer.initialize();
@@ -20,9 +58,39 @@ namespace xeno
 
     void Engine::run()
     {
+        uint32_t frame = 0;
         while (!window.shouldClose())
         {
+            // The renderer does not submit work yet; once it does, wait on this
+            // slot's in-flight fence here before its arena is recycled.
+            frameArenas.beginFrame(frame);
+
             window.pollEvents();
+            mainThreadQueue.runPending();
+
+            // The main thread helps run the graph until every node has finished
+            taskGraph.run();
+
+            checkMemoryBudgets();
+            frame = (frame + 1) % xeno::vulkan::VulkanRenderer::MAX_FRAMES_IN_FLIGHT;
+        }
+    }
+
+    void Engine::checkMemoryBudgets()
+    {
+        uint32_t exceeded = xeno::pal::memory::sample();
+        if (exceeded == 0)
+        {
+            return;
+        }
+        for (uint32_t i = 0; i < static_cast<uint32_t>(xeno::pal::MemoryTag::Count); ++i)
+        {
+            if (exceeded & (1u << i))
+            {
+                xeno::pal::MemoryTagStats stats = xeno::pal::memory::stats(static_cast<xeno::pal::MemoryTag>(i));
+                std::cerr << "Memory budget exceeded for " << stats.name << ": "
+                          << stats.currentBytes << " / " << stats.budgetBytes << " bytes" << std::endl;
+            }
         }
     }
 }
@@ -1,4 +1,6 @@
 #include "xeno-pal.hpp"
+#include "xeno-pal-taskgraph.hpp"
+#include "xeno-pal-coroutine.hpp"
 #include "vulkan-renderer.hpp"
 
 namespace xeno
@@ -8,6 +10,17 @@ namespace xeno
         int width;
         int height;
         const char *title;
+        // Address space reserved for each per-frame arena; pages are only
+        // committed as frames actually use them.
+        size_t frameArenaSize = 64 * 1024 * 1024;
+        // 0 uses one worker per physical core, leaving one for the main thread
+        size_t workerThreads = 0;
+        // Pins the main thread and each worker to its own physical core. Off by
+        // default: pinning moves the caller's own thread and suits a dedicated
+        // machine better than one shared with other processes.
+        bool pinThreads = false;
+        // Asset and file streaming runs on these so it never blocks a worker
+        size_t ioThreads = 2;
     };
 
     class Engine
@@ -21,9 +34,34 @@ namespace xeno
         static Engine &getInstance();
         void run();
 
+        // Scratch memory that lives until this frame slot comes around again
+        xeno::pal::Arena &frameArena() { return frameArenas.current(); }
+        uint32_t currentFrame() const { return frameArenas.frameIndex(); }
+
+        // Per-frame work (simulation, culling, command recording, ...) is added
+        // to the frame graph once and executed by run() every frame, after input
+        // has been polled on the main thread.
+        xeno::pal::TaskGraph &frameGraph() { return taskGraph; }
+        xeno::pal::ThreadPool &threadPool() { return workers; }
+        // Drained on the main thread once per frame, before the frame graph.
+        // Coroutines use it through pal::nextFrame and pal::waitUntil.
+        xeno::pal::MainThreadQueue &mainThread() { return mainThreadQueue; }
+
+        // Current and sampled peak bytes per memory tag across every PAL allocator
+        std::vector<xeno::pal::MemoryTagStats> memoryReport() const { return xeno::pal::memory::report(); }
+        void setMemoryBudget(xeno::pal::MemoryTag tag, size_t bytes) { xeno::pal::memory::setBudget(tag, bytes); }
+
     private:
+        void checkMemoryBudgets();
+
         xeno::pal::XenoWindow window;
         xeno::EngineConfig config;
         xeno::vulkan::VulkanRenderer renderer;
+        xeno::pal::FrameArenas frameArenas;
+        // Declared before the pool so coroutines still running during pool
+        // shutdown can post to it
+        xeno::pal::MainThreadQueue mainThreadQueue;
+        xeno::pal::ThreadPool workers;
+        xeno::pal::TaskGraph taskGraph;
     };
 }
\ No newline at end of file
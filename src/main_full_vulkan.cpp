@@ -11,6 +11,7 @@
 #include <limits>
 #include <cmath>
 #include <chrono>
+#include <cstdio>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -25,6 +26,8 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_vulkan.h"
 
+#include "xeno-pal/xeno-pal-parallel.hpp"
+
 const uint32_t WIDTH = 1200;
 const uint32_t HEIGHT = 800;
 const int MAX_FRAMES_IN_FLIGHT = 2;
@@ -170,6 +173,13 @@ private:
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
 
+    xeno::pal::ThreadPool workers;
+    // Busy/idle totals at the last panel refresh, for per-interval utilization
+    std::vector<double> lastWorkerBusyMs;
+    std::vector<double> lastWorkerIdleMs;
+    std::vector<float> workerUtilization;
+    double lastPoolStatsTime = 0.0;
+
     auto startTime = std::chrono::high_resolution_clock::now();
 
     void initWindow()
@@ -213,47 +223,52 @@ private:
 
     void generateTerrain()
     {
-        vertices.clear();
-        indices.clear();
-
-        // Generate terrain vertices
-        for (int z = 0; z < config.terrainSize; z++)
-        {
-            for (int x = 0; x < config.terrainSize; x++)
+        const int size = config.terrainSize;
+        vertices.resize(static_cast<size_t>(size) * size);
+        indices.resize(static_cast<size_t>(size - 1) * (size - 1) * 6);
+
+        // Generate terrain vertices, one row per iteration
+        xeno::pal::parallelFor(workers, 0, size, [&](size_t firstRow, size_t lastRow)
+                               {
+            for (int z = static_cast<int>(firstRow); z < static_cast<int>(lastRow); z++)
             {
-                Vertex vertex{};
-                vertex.pos = {
-                    x - config.terrainSize / 2.0f,
-                    0.0f,
-                    z - config.terrainSize / 2.0f};
-                vertex.texCoord = {
-                    (float)x / (config.terrainSize - 1),
-                    (float)z / (config.terrainSize - 1)};
-                vertices.push_back(vertex);
-            }
-        }
-
-        // Generate indices
-        for (int z = 0; z < config.terrainSize - 1; z++)
-        {
-            for (int x = 0; x < config.terrainSize - 1; x++)
+                for (int x = 0; x < size; x++)
+                {
+                    Vertex &vertex = vertices[z * size + x];
+                    vertex.pos = {
+                        x - size / 2.0f,
+                        0.0f,
+                        z - size / 2.0f};
+                    vertex.texCoord = {
+                        (float)x / (size - 1),
+                        (float)z / (size - 1)};
+                }
+            } });
+
+        // Generate indices; each quad writes its own six slots
+        xeno::pal::parallelFor(workers, 0, size - 1, [&](size_t firstRow, size_t lastRow)
+                               {
+            for (int z = static_cast<int>(firstRow); z < static_cast<int>(lastRow); z++)
             {
-                uint32_t topLeft = z * config.terrainSize + x;
-                uint32_t topRight = topLeft + 1;
-                uint32_t bottomLeft = (z + 1) * config.terrainSize + x;
-                uint32_t bottomRight = bottomLeft + 1;
-
-                // First triangle
-                indices.push_back(topLeft);
-                indices.push_back(bottomLeft);
-                indices.push_back(topRight);
-
-                // Second triangle
-                indices.push_back(topRight);
-                indices.push_back(bottomLeft);
-                indices.push_back(bottomRight);
-            }
-        }
+                uint32_t *out = &indices[static_cast<size_t>(z) * (size - 1) * 6];
+                for (int x = 0; x < size - 1; x++)
+                {
+                    uint32_t topLeft = z * size + x;
+                    uint32_t topRight = topLeft + 1;
+                    uint32_t bottomLeft = (z + 1) * size + x;
+                    uint32_t bottomRight = bottomLeft + 1;
+
+                    // First triangle
+                    *out++ = topLeft;
+                    *out++ = bottomLeft;
+                    *out++ = topRight;
+
+                    // Second triangle
+                    *out++ = topRight;
+                    *out++ = bottomLeft;
+                    *out++ = bottomRight;
+                }
+            } });
     }
 
     void setupImGui()
@@ -480,6 +495,59 @@ private:
         ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
 
         ImGui::End();
+
+        renderThreadPoolStats();
+    }
+
+    void renderThreadPoolStats()
+    {
+        ImGui::Begin("🧵 Thread Pool");
+
+        xeno::pal::ThreadPoolStats stats = workers.stats();
+        size_t count = stats.workers.size();
+        if (workerUtilization.size() != count)
+        {
+            lastWorkerBusyMs.assign(count, 0.0);
+            lastWorkerIdleMs.assign(count, 0.0);
+            workerUtilization.assign(count, 0.0f);
+        }
+        double now = ImGui::GetTime();
+        if (now - lastPoolStatsTime >= 0.5)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                double busy = stats.workers[i].busyMs - lastWorkerBusyMs[i];
+                double idle = stats.workers[i].idleMs - lastWorkerIdleMs[i];
+                workerUtilization[i] = busy + idle > 0.0 ? static_cast<float>(busy / (busy + idle)) : 0.0f;
+                lastWorkerBusyMs[i] = stats.workers[i].busyMs;
+                lastWorkerIdleMs[i] = stats.workers[i].idleMs;
+            }
+            lastPoolStatsTime = now;
+        }
+
+        ImGui::Text("Workers: %zu  Queued: %zu", count, stats.queueDepth);
+        ImGui::Text("Queue wait  p50 %.1f us  p99 %.1f us  max %.1f us", stats.queueWait.p50Us, stats.queueWait.p99Us, stats.queueWait.maxUs);
+        ImGui::Text("Execution   p50 %.1f us  p99 %.1f us  max %.1f us", stats.execution.p50Us, stats.execution.p99Us, stats.execution.maxUs);
+        ImGui::Text("Idle: spun %.1f ms, %llu spin hits, %llu parks (avg wake %.1f us)", stats.idle.spinMs(),
+                    static_cast<unsigned long long>(stats.idle.spinHits), static_cast<unsigned long long>(stats.idle.parks),
+                    stats.idle.averageWakeLatencyUs());
+
+        ImGui::Separator();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const xeno::pal::WorkerStats &worker = stats.workers[i];
+            char label[64];
+            std::snprintf(label, sizeof(label), "%.0f%%", workerUtilization[i] * 100.0f);
+            ImGui::Text("#%zu", i);
+            ImGui::SameLine();
+            ImGui::ProgressBar(workerUtilization[i], ImVec2(120.0f, 0.0f), label);
+            ImGui::SameLine();
+            ImGui::Text("%llu tasks, %llu steals, exec p99 %.1f us", static_cast<unsigned long long>(worker.tasksExecuted),
+                        static_cast<unsigned long long>(worker.steals), worker.execution.p99Us);
+        }
+        ImGui::Text("Main thread helped with %llu tasks", static_cast<unsigned long long>(stats.helpers.tasksExecuted));
+
+        ImGui::End();
     }
 
     void updateUniformBuffer(uint32_t currentImage)
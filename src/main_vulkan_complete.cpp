@@ -25,6 +25,8 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_vulkan.h"
 
+#include "xeno-pal/xeno-pal-parallel.hpp"
+
 const uint32_t WIDTH = 1200;
 const uint32_t HEIGHT = 800;
 const int MAX_FRAMES_IN_FLIGHT = 2;
@@ -189,6 +191,8 @@ private:
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
 
+    xeno::pal::ThreadPool workers;
+
     auto startTime = std::chrono::high_resolution_clock::now();
 
     void initWindow()
@@ -931,47 +935,52 @@ private:
 
     void generateTerrain()
     {
-        vertices.clear();
-        indices.clear();
+        const int size = config.terrainSize;
+        vertices.resize(static_cast<size_t>(size) * size);
+        indices.resize(static_cast<size_t>(size - 1) * (size - 1) * 6);
 
-        // Generate terrain vertices
-        for (int z = 0; z < config.terrainSize; z++)
-        {
-            for (int x = 0; x < config.terrainSize; x++)
+        // Generate terrain vertices, one row per iteration
+        xeno::pal::parallelFor(workers, 0, size, [&](size_t firstRow, size_t lastRow)
+                               {
+            for (int z = static_cast<int>(firstRow); z < static_cast<int>(lastRow); z++)
             {
-                Vertex vertex{};
-                vertex.pos = {
-                    x - config.terrainSize / 2.0f,
-                    0.0f,
-                    z - config.terrainSize / 2.0f};
-                vertex.texCoord = {
-                    (float)x / (config.terrainSize - 1),
-                    (float)z / (config.terrainSize - 1)};
-                vertices.push_back(vertex);
-            }
-        }
+                for (int x = 0; x < size; x++)
+                {
+                    Vertex &vertex = vertices[z * size + x];
+                    vertex.pos = {
+                        x - size / 2.0f,
+                        0.0f,
+                        z - size / 2.0f};
+                    vertex.texCoord = {
+                        (float)x / (size - 1),
+                        (float)z / (size - 1)};
+                }
+            } });
 
-        // Generate indices
-        for (int z = 0; z < config.terrainSize - 1; z++)
-        {
-            for (int x = 0; x < config.terrainSize - 1; x++)
+        // Generate indices; each quad writes its own six slots
+        xeno::pal::parallelFor(workers, 0, size - 1, [&](size_t firstRow, size_t lastRow)
+                               {
+            for (int z = static_cast<int>(firstRow); z < static_cast<int>(lastRow); z++)
             {
-                uint32_t topLeft = z * config.terrainSize + x;
-                uint32_t topRight = topLeft + 1;
-                uint32_t bottomLeft = (z + 1) * config.terrainSize + x;
-                uint32_t bottomRight = bottomLeft + 1;
-
-                // First triangle
-                indices.push_back(topLeft);
-                indices.push_back(bottomLeft);
-                indices.push_back(topRight);
-
-                // Second triangle
-                indices.push_back(topRight);
-                indices.push_back(bottomLeft);
-                indices.push_back(bottomRight);
-            }
-        }
+                uint32_t *out = &indices[static_cast<size_t>(z) * (size - 1) * 6];
+                for (int x = 0; x < size - 1; x++)
+                {
+                    uint32_t topLeft = z * size + x;
+                    uint32_t topRight = topLeft + 1;
+                    uint32_t bottomLeft = (z + 1) * size + x;
+                    uint32_t bottomRight = bottomLeft + 1;
+
+                    // First triangle
+                    *out++ = topLeft;
+                    *out++ = bottomLeft;
+                    *out++ = topRight;
+
+                    // Second triangle
+                    *out++ = topRight;
+                    *out++ = bottomLeft;
+                    *out++ = bottomRight;
+                }
+            } });
     }
 
     // Simplified implementations for core functionality
@@ -7,6 +7,8 @@ namespace xeno
         class VulkanRenderer
         {
         public:
+            static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
             VulkanRenderer();
             ~VulkanRenderer();
             void initialize();
@@ -30,7 +30,23 @@ namespace xeno
 
             std::vector<char> data(size);
             file.read(data.data(), size);
-            if (file.gcount() != size)
+            if (file.gcount() != static_cast<std::streamsize>(size))
+            {
+                throw std::runtime_error("Failed to read the expected number of bytes!");
+            }
+            return data;
+        }
+
+        std::pmr::vector<char> File::read(size_t size, std::pmr::memory_resource *resource)
+        {
+            if (!file.is_open())
+            {
+                throw std::runtime_error("File not open!");
+            }
+
+            std::pmr::vector<char> data(size, resource);
+            file.read(data.data(), size);
+            if (file.gcount() != static_cast<std::streamsize>(size))
             {
                 throw std::runtime_error("Failed to read the expected number of bytes!");
             }
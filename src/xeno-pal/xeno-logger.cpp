@@ -1,59 +1,1170 @@
-#include "xeno-pal.hpp"
+#include "xeno-pal-logger.hpp"
+#include "xeno-pal-memory.hpp"
+#include <algorithm>
 #include <chrono>
-#include <iostream>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace xeno
 {
     namespace pal
     {
-        Logger::Logger(const std::string &filename) : m_logFile(filename, std::ios::out | std::ios::app)
+        namespace
         {
-            if (!m_logFile.is_open())
+            // The writer hands the file this much at a time under load
+            constexpr size_t WriteBatchBytes = 64 * 1024;
+
+            // Plain log() messages, so binary logs can carry them too
+            constexpr LogSite TextSites[] = {
+                {"{}", LogLevel::Trace, "", 0},
+                {"{}", LogLevel::Debug, "", 0},
+                {"{}", LogLevel::Info, "", 0},
+                {"{}", LogLevel::Warning, "", 0},
+                {"{}", LogLevel::Error, "", 0},
+            };
+            constexpr LogSite DroppedSite = {"{} log records dropped, ring buffer full", LogLevel::Warning, __FILE__, __LINE__};
+
+            const char *levelToString(LogLevel level)
+            {
+                switch (level)
+                {
+                case LogLevel::Trace:
+                    return "Trace";
+                case LogLevel::Debug:
+                    return "Debug";
+                case LogLevel::Info:
+                    return "Info";
+                case LogLevel::Warning:
+                    return "Warning";
+                case LogLevel::Error:
+                    return "Error";
+                }
+                return "Unknown";
+            }
+
+            // "YYYY-MM-DD HH:MM:SS" only changes once a second, so the writer
+            // formats it once and reuses it for every record in that second
+            class TimestampFormatter
+            {
+            public:
+                void append(std::string &out, uint64_t timeNs)
+                {
+                    std::time_t second = static_cast<std::time_t>(timeNs / 1000000000ull);
+                    if (second != m_second)
+                    {
+                        std::tm local{};
+#if defined(_WIN32)
+                        localtime_s(&local, &second);
+#else
+                        localtime_r(&second, &local);
+#endif
+                        m_length = std::strftime(m_prefix, sizeof(m_prefix), "%Y-%m-%d %H:%M:%S", &local);
+                        m_second = second;
+                    }
+                    char millis[8];
+                    std::snprintf(millis, sizeof(millis), ".%03u", static_cast<unsigned>(timeNs / 1000000ull % 1000ull));
+                    out.append(m_prefix, m_length);
+                    out.append(millis);
+                }
+
+            private:
+                std::time_t m_second = -1;
+                char m_prefix[32] = {};
+                size_t m_length = 0;
+            };
+
+            void appendPrefix(std::string &out, TimestampFormatter &timestamps, LogLevel level, uint64_t timeNs)
+            {
+                timestamps.append(out, timeNs);
+                out += " [";
+                out += levelToString(level);
+                out += "] ";
+            }
+
+            template <typename T>
+            void put(std::string &out, T value)
+            {
+                out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+
+            void putString(std::string &out, std::string_view value)
+            {
+                uint16_t size = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+                put(out, size);
+                out.append(value.data(), size);
+            }
+
+            // Turns records into file contents for the configured encoding.
+            // Writer thread only.
+            class EntryEncoder
+            {
+            public:
+                explicit EntryEncoder(LogEncoding encoding) : m_encoding(encoding) {}
+
+                void appendMessage(std::string &out, LogLevel level, uint64_t timeNs, std::string_view text)
+                {
+                    if (m_encoding == LogEncoding::Text)
+                    {
+                        appendPrefix(out, m_timestamps, level, timeNs);
+                        out.append(text);
+                        out += '\n';
+                        return;
+                    }
+                    char args[Logger::MaxMessageLength + 3];
+                    size_t used = 0;
+                    binarylog::packString(args, sizeof(args), used, text);
+                    appendStructured(out, TextSites[static_cast<size_t>(level)], timeNs, args, used);
+                }
+
+                void appendStructured(std::string &out, const LogSite &site, uint64_t timeNs, const char *args, size_t size)
+                {
+                    if (m_encoding == LogEncoding::Text)
+                    {
+                        appendPrefix(out, m_timestamps, site.level, timeNs);
+                        binarylog::formatPacked(out, site.format, args, size);
+                        out += '\n';
+                        return;
+                    }
+                    uint32_t id = idFor(out, site);
+                    put(out, binarylog::EntryType::Record);
+                    put(out, id);
+                    put(out, timeNs);
+                    putString(out, std::string_view(args, size));
+                }
+
+            private:
+                // Sites are numbered the first time the writer sees them
+                uint32_t idFor(std::string &out, const LogSite &site)
+                {
+                    auto found = m_ids.find(&site);
+                    if (found != m_ids.end())
+                    {
+                        return found->second;
+                    }
+                    uint32_t id = static_cast<uint32_t>(m_ids.size());
+                    m_ids.emplace(&site, id);
+                    put(out, binarylog::EntryType::Format);
+                    put(out, id);
+                    put(out, site.level);
+                    put(out, static_cast<uint32_t>(site.line));
+                    putString(out, site.file);
+                    putString(out, site.format);
+                    return id;
+                }
+
+                LogEncoding m_encoding;
+                TimestampFormatter m_timestamps;
+                std::unordered_map<const LogSite *, uint32_t> m_ids;
+            };
+
+            // How long the writer holds a record back in case another thread
+            // stamped an earlier one that it has not pushed yet
+            constexpr uint64_t MergeGraceNs = 100 * 1000;
+
+            std::atomic<uint64_t> nextLoggerId{1};
+
+            uint64_t steadyNs()
+            {
+                return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                 std::chrono::steady_clock::now().time_since_epoch())
+                                                 .count());
+            }
+
+            uint64_t wallClockNs()
+            {
+                return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                 std::chrono::system_clock::now().time_since_epoch())
+                                                 .count());
+            }
+
+            // Nanoseconds per logTicks() tick, measured once per process over
+            // a millisecond. Only the TSC needs it.
+            double measuredNsPerTick()
+            {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+                static const double nsPerTick = []()
+                {
+                    uint64_t startTicks = logTicks();
+                    uint64_t startNs = steadyNs();
+                    uint64_t ns = startNs;
+                    while (ns - startNs < 1000000)
+                    {
+                        ns = steadyNs();
+                    }
+                    return static_cast<double>(ns - startNs) / static_cast<double>(logTicks() - startTicks);
+                }();
+                return nsPerTick;
+#else
+                return 1.0;
+#endif
+            }
+
+            // Maps record ticks to wall-clock time from one (ticks, steady,
+            // wall) sample taken when the logger was created. Writer thread only.
+            class TickConverter
+            {
+            public:
+                TickConverter(uint64_t baseTicks, uint64_t baseSteadyNs, uint64_t baseWallNs)
+                    : m_baseTicks(baseTicks), m_baseSteadyNs(baseSteadyNs), m_baseWallNs(baseWallNs), m_nsPerTick(measuredNsPerTick())
+                {
+                }
+
+                // After the first second, re-derives the rate from everything
+                // since the base sample, which only gets more precise
+                void refine()
+                {
+                    uint64_t ticks = logTicks();
+                    uint64_t elapsedNs = steadyNs() - m_baseSteadyNs;
+                    if (elapsedNs >= 1000000000ull && ticks > m_baseTicks)
+                    {
+                        m_nsPerTick = static_cast<double>(elapsedNs) / static_cast<double>(ticks - m_baseTicks);
+                    }
+                }
+
+                uint64_t toWallNs(uint64_t ticks) const
+                {
+                    // Signed: another core's counter may read a little behind the base
+                    double offset = static_cast<double>(static_cast<int64_t>(ticks - m_baseTicks)) * m_nsPerTick;
+                    return m_baseWallNs + static_cast<uint64_t>(static_cast<int64_t>(offset));
+                }
+
+                uint64_t ticksFor(uint64_t ns) const { return static_cast<uint64_t>(static_cast<double>(ns) / m_nsPerTick); }
+
+            private:
+                uint64_t m_baseTicks;
+                uint64_t m_baseSteadyNs;
+                uint64_t m_baseWallNs;
+                double m_nsPerTick;
+            };
+
+            void syncToDisk(std::FILE *file)
             {
-                throw std::runtime_error("Failed to open log file.");
+#if defined(_WIN32)
+                _commit(_fileno(file));
+#else
+                fsync(fileno(file));
+#endif
+            }
+
+            // Keeps a single entry from ever being larger than a whole file
+            constexpr size_t MinRotateBytes = 64 * 1024;
+
+            // File size of a Mapped sink left at rotateBytes = 0, which has to
+            // rotate since it cannot grow past its mapping
+            constexpr size_t DefaultMappedBytes = 64 * 1024 * 1024;
+
+            // A file mapped read-write in its entirety. Platform layer for
+            // LogSink::Mapped.
+            class MappedFile
+            {
+            public:
+                bool open(const std::string &path)
+                {
+#if defined(_WIN32)
+                    m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                         nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+                    LARGE_INTEGER size;
+                    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+                    {
+                        close(0);
+                        return false;
+                    }
+                    m_size = static_cast<size_t>(size.QuadPart);
+#else
+                    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+                    struct stat info;
+                    if (m_fd < 0 || fstat(m_fd, &info) != 0)
+                    {
+                        close(0);
+                        return false;
+                    }
+                    m_size = static_cast<size_t>(info.st_size);
+#endif
+                    return true;
+                }
+
+                // Grows the file to size with its blocks allocated up front, so a
+                // full disk fails here rather than as a fault on a later store
+                bool map(size_t size)
+                {
+#if defined(_WIN32)
+                    LARGE_INTEGER end;
+                    end.QuadPart = static_cast<LONGLONG>(size);
+                    if (!SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file))
+                    {
+                        return false;
+                    }
+                    m_size = size;
+                    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+                    if (!m_mapping)
+                    {
+                        return false;
+                    }
+                    m_view = static_cast<char *>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, size));
+#else
+#if defined(__linux__)
+                    if (posix_fallocate(m_fd, 0, static_cast<off_t>(size)) != 0)
+#else
+                    if (ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+#endif
+                    {
+                        return false;
+                    }
+                    m_size = size;
+                    void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+                    m_view = view == MAP_FAILED ? nullptr : static_cast<char *>(view);
+#endif
+                    return m_view != nullptr;
+                }
+
+                size_t size() const { return m_size; }
+                char *data() const { return m_view; }
+
+                void sync(size_t offset, size_t size)
+                {
+#if defined(_WIN32)
+                    FlushViewOfFile(m_view + offset, size);
+                    FlushFileBuffers(m_file);
+#else
+                    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                    size_t start = offset / page * page;
+                    msync(m_view + start, offset + size - start, MS_SYNC);
+#endif
+                }
+
+                // Unmaps and closes, cutting the file down to size
+                void close(size_t size)
+                {
+#if defined(_WIN32)
+                    if (m_view)
+                    {
+                        UnmapViewOfFile(m_view);
+                    }
+                    if (m_mapping)
+                    {
+                        CloseHandle(m_mapping);
+                    }
+                    if (m_file != INVALID_HANDLE_VALUE)
+                    {
+                        LARGE_INTEGER end;
+                        end.QuadPart = static_cast<LONGLONG>(size);
+                        if (SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN))
+                        {
+                            SetEndOfFile(m_file);
+                        }
+                        CloseHandle(m_file);
+                    }
+                    m_file = INVALID_HANDLE_VALUE;
+                    m_mapping = nullptr;
+#else
+                    if (m_view)
+                    {
+                        munmap(m_view, m_size);
+                    }
+                    if (m_fd >= 0)
+                    {
+                        (void)ftruncate(m_fd, static_cast<off_t>(size));
+                        ::close(m_fd);
+                    }
+                    m_fd = -1;
+#endif
+                    m_view = nullptr;
+                    m_size = 0;
+                }
+
+            private:
+#if defined(_WIN32)
+                HANDLE m_file = INVALID_HANDLE_VALUE;
+                HANDLE m_mapping = nullptr;
+#else
+                int m_fd = -1;
+#endif
+                char *m_view = nullptr;
+                size_t m_size = 0;
+            };
+
+            template <typename T>
+            T read(std::istream &in)
+            {
+                T value;
+                if (!in.read(reinterpret_cast<char *>(&value), sizeof(value)))
+                {
+                    throw std::runtime_error("Binary log is truncated");
+                }
+                return value;
+            }
+
+            std::string readString(std::istream &in)
+            {
+                std::string value(read<uint16_t>(in), '\0');
+                if (!in.read(value.data(), static_cast<std::streamsize>(value.size())))
+                {
+                    throw std::runtime_error("Binary log is truncated");
+                }
+                return value;
+            }
+        }
+
+        namespace binarylog
+        {
+            void formatPacked(std::string &out, std::string_view format, const char *args, size_t size)
+            {
+                size_t offset = 0;
+                for (size_t i = 0; i < format.size(); ++i)
+                {
+                    if (format[i] != '{' || i + 1 >= format.size() || format[i + 1] != '}' || offset >= size)
+                    {
+                        out += format[i];
+                        continue;
+                    }
+                    ++i;
+
+                    ArgType type = static_cast<ArgType>(args[offset++]);
+                    size_t valueSize = type == ArgType::String ? sizeof(uint16_t) : sizeof(uint64_t);
+                    if (offset + valueSize > size)
+                    {
+                        return;
+                    }
+                    char number[32];
+                    switch (type)
+                    {
+                    case ArgType::Int:
+                    {
+                        int64_t value;
+                        std::memcpy(&value, args + offset, sizeof(value));
+                        std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(value));
+                        out += number;
+                        break;
+                    }
+                    case ArgType::UInt:
+                    {
+                        uint64_t value;
+                        std::memcpy(&value, args + offset, sizeof(value));
+                        std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(value));
+                        out += number;
+                        break;
+                    }
+                    case ArgType::Double:
+                    {
+                        double value;
+                        std::memcpy(&value, args + offset, sizeof(value));
+                        std::snprintf(number, sizeof(number), "%g", value);
+                        out += number;
+                        break;
+                    }
+                    case ArgType::String:
+                    {
+                        uint16_t length;
+                        std::memcpy(&length, args + offset, sizeof(length));
+                        offset += sizeof(length);
+                        length = static_cast<uint16_t>(std::min<size_t>(length, size - offset));
+                        out.append(args + offset, length);
+                        offset += length;
+                        continue;
+                    }
+                    default:
+                        return;
+                    }
+                    offset += valueSize;
+                }
+            }
+
+            void decode(std::istream &in, std::ostream &out)
+            {
+                char magic[sizeof(Magic)];
+                if (!in.read(magic, sizeof(magic)))
+                {
+                    throw std::runtime_error("Not a xeno binary log");
+                }
+                if (std::memcmp(magic, MappedLogHeader::Magic, sizeof(magic)) == 0)
+                {
+                    MappedLogHeader header;
+                    std::memcpy(header.magic, magic, sizeof(magic));
+                    if (!in.read(reinterpret_cast<char *>(&header) + sizeof(magic), sizeof(header) - sizeof(magic)))
+                    {
+                        throw std::runtime_error("Mapped log header is truncated");
+                    }
+                    // Checked before allocating, so a corrupt length cannot
+                    // ask for more memory than the file holds
+                    std::streampos start = in.tellg();
+                    if (start != std::streampos(-1) && in.seekg(0, std::ios::end))
+                    {
+                        std::streamoff remaining = in.tellg() - start;
+                        in.seekg(start);
+                        if (remaining < 0 || header.committed > static_cast<uint64_t>(remaining))
+                        {
+                            throw std::runtime_error("Mapped log is shorter than its committed length");
+                        }
+                    }
+                    in.clear();
+                    std::string contents(header.committed, '\0');
+                    if (!in.read(contents.data(), static_cast<std::streamsize>(contents.size())))
+                    {
+                        throw std::runtime_error("Mapped log is shorter than its committed length");
+                    }
+                    if (contents.compare(0, sizeof(Magic), Magic, sizeof(Magic)) != 0)
+                    {
+                        out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+                        return;
+                    }
+                    std::istringstream binary(std::move(contents));
+                    decode(binary, out);
+                    return;
+                }
+                if (std::memcmp(magic, Magic, sizeof(Magic)) != 0)
+                {
+                    throw std::runtime_error("Not a xeno binary log");
+                }
+
+                struct Format
+                {
+                    LogLevel level;
+                    std::string format;
+                };
+                std::unordered_map<uint32_t, Format> formats;
+                TimestampFormatter timestamps;
+                std::string line;
+
+                for (int type = in.get(); type != std::char_traits<char>::eof(); type = in.get())
+                {
+                    switch (static_cast<EntryType>(type))
+                    {
+                    case EntryType::Format:
+                    {
+                        uint32_t id = read<uint32_t>(in);
+                        LogLevel level = read<LogLevel>(in);
+                        read<uint32_t>(in); // line
+                        readString(in);     // file
+                        formats[id] = {level, readString(in)};
+                        break;
+                    }
+                    case EntryType::Record:
+                    {
+                        uint32_t id = read<uint32_t>(in);
+                        uint64_t timeNs = read<uint64_t>(in);
+                        std::string args = readString(in);
+                        auto found = formats.find(id);
+                        if (found == formats.end())
+                        {
+                            throw std::runtime_error("Binary log record uses undefined format " + std::to_string(id));
+                        }
+                        line.clear();
+                        appendPrefix(line, timestamps, found->second.level, timeNs);
+                        formatPacked(line, found->second.format, args.data(), args.size());
+                        line += '\n';
+                        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+                        break;
+                    }
+                    default:
+                        throw std::runtime_error("Binary log has an unknown entry type " + std::to_string(type));
+                    }
+                }
             }
         }
 
+        uint64_t logTicksPerSecond()
+        {
+            static const uint64_t ticks = static_cast<uint64_t>(1e9 / measuredNsPerTick());
+            return ticks;
+        }
+
+        // The writer thread's output file, rotated once it would pass
+        // rotateBytes. Writer thread only once constructed. If a rotated-in
+        // file cannot be opened, output is discarded from then on.
+        class Logger::Sink
+        {
+        public:
+            Sink(const std::string &path, const LoggerConfig &config)
+                : m_path(path), m_kind(config.sink), m_binary(config.encoding == LogEncoding::Binary),
+                  m_rotateBytes(config.rotateBytes), m_keepFiles(config.keepFiles)
+            {
+                if (m_kind == LogSink::Mapped && m_rotateBytes == 0)
+                {
+                    m_rotateBytes = DefaultMappedBytes;
+                }
+                if (m_rotateBytes != 0 && m_rotateBytes < MinRotateBytes)
+                {
+                    throw std::runtime_error("Logger rotateBytes must be at least 64 KiB");
+                }
+                if (!open())
+                {
+                    throw std::runtime_error("Failed to open log file.");
+                }
+            }
+
+            ~Sink() { close(); }
+
+            // Bytes in the current file
+            size_t size() const { return m_size; }
+
+            // Bytes that can be written before the file has to rotate
+            size_t room() const
+            {
+                if (!m_open || m_rotateBytes == 0)
+                {
+                    return SIZE_MAX;
+                }
+                size_t limit = m_kind == LogSink::Mapped ? m_capacity : m_rotateBytes;
+                return m_size < limit ? limit - m_size : 0;
+            }
+
+            void write(const char *data, size_t size)
+            {
+                if (!m_open)
+                {
+                    return;
+                }
+                if (m_kind == LogSink::File)
+                {
+                    std::fwrite(data, 1, size, m_file);
+                    m_size += size;
+                    return;
+                }
+                size = std::min(size, m_capacity - m_size);
+                std::memcpy(m_mapped.data() + sizeof(MappedLogHeader) + m_size, data, size);
+                m_size += size;
+                // Published after the bytes it covers
+                std::atomic_ref<uint64_t>(header().committed).store(m_size, std::memory_order_release);
+            }
+
+            // Makes written bytes visible to readers of the file. Stores to a
+            // mapping already are.
+            void flush()
+            {
+                if (m_open && m_kind == LogSink::File)
+                {
+                    std::fflush(m_file);
+                }
+            }
+
+            void sync()
+            {
+                if (!m_open)
+                {
+                    return;
+                }
+                if (m_kind == LogSink::File)
+                {
+                    syncToDisk(m_file);
+                    return;
+                }
+                // Log bytes first, so the header never gets ahead of them on disk
+                m_mapped.sync(sizeof(MappedLogHeader), m_size);
+                m_mapped.sync(0, sizeof(MappedLogHeader));
+            }
+
+            void rotate()
+            {
+                close();
+                shiftRotated();
+                m_open = open();
+            }
+
+        private:
+            MappedLogHeader &header() const { return *reinterpret_cast<MappedLogHeader *>(m_mapped.data()); }
+
+            bool open()
+            {
+                m_open = m_kind == LogSink::File ? openFile() : openMapped();
+                return m_open;
+            }
+
+            bool openFile()
+            {
+                m_file = std::fopen(m_path.c_str(), m_binary ? "ab" : "a");
+                if (!m_file)
+                {
+                    return false;
+                }
+                std::fseek(m_file, 0, SEEK_END);
+                m_size = static_cast<size_t>(std::ftell(m_file));
+                return true;
+            }
+
+            // Appends to an existing mapped file if it has room, which also
+            // picks up after a crash. Anything else already at the path is
+            // rotated away first rather than overwritten.
+            bool openMapped()
+            {
+                m_capacity = m_rotateBytes - sizeof(MappedLogHeader);
+                for (int attempt = 0; attempt < 2; ++attempt)
+                {
+                    if (!m_mapped.open(m_path))
+                    {
+                        return false;
+                    }
+                    size_t existing = m_mapped.size();
+                    if (!m_mapped.map(std::max(existing, m_rotateBytes)))
+                    {
+                        m_mapped.close(existing);
+                        return false;
+                    }
+                    MappedLogHeader &current = header();
+                    if (existing == 0)
+                    {
+                        std::memcpy(current.magic, MappedLogHeader::Magic, sizeof(current.magic));
+                        current.committed = 0;
+                        current.capacity = m_capacity;
+                        m_size = 0;
+                        return true;
+                    }
+
+                    bool mapped = existing >= sizeof(MappedLogHeader) &&
+                                  std::memcmp(current.magic, MappedLogHeader::Magic, sizeof(current.magic)) == 0 &&
+                                  current.committed <= existing - sizeof(MappedLogHeader);
+                    if (mapped && current.committed < m_capacity)
+                    {
+                        current.capacity = m_capacity;
+                        m_size = current.committed;
+                        return true;
+                    }
+                    m_mapped.close(mapped ? sizeof(MappedLogHeader) + current.committed : existing);
+                    shiftRotated();
+                }
+                return false;
+            }
+
+            void close()
+            {
+                if (!m_open)
+                {
+                    return;
+                }
+                if (m_kind == LogSink::File)
+                {
+                    std::fclose(m_file);
+                    m_file = nullptr;
+                }
+                else
+                {
+                    m_mapped.close(sizeof(MappedLogHeader) + m_size);
+                }
+                m_open = false;
+            }
+
+            // <name>.<keepFiles> is deleted, the rest move up one, and the
+            // current file becomes <name>.1
+            void shiftRotated()
+            {
+                auto numbered = [this](uint32_t index)
+                { return m_path + "." + std::to_string(index); };
+                if (m_keepFiles == 0)
+                {
+                    std::remove(m_path.c_str());
+                    return;
+                }
+                std::remove(numbered(m_keepFiles).c_str());
+                for (uint32_t index = m_keepFiles - 1; index > 0; --index)
+                {
+                    std::rename(numbered(index).c_str(), numbered(index + 1).c_str());
+                }
+                std::rename(m_path.c_str(), numbered(1).c_str());
+            }
+
+            std::string m_path;
+            LogSink m_kind;
+            bool m_binary;
+            size_t m_rotateBytes;
+            uint32_t m_keepFiles;
+            bool m_open = false;
+            size_t m_size = 0; // File: bytes in the file; Mapped: committed bytes
+
+            std::FILE *m_file = nullptr;
+            MappedFile m_mapped;
+            size_t m_capacity = 0; // Mapped: bytes of log a file holds
+        };
+
+        struct Logger::ThreadBuffer
+        {
+            explicit ThreadBuffer(size_t capacity) : queue(capacity)
+            {
+                memory::recordAllocation(MemoryTag::Logger, queue.capacity() * sizeof(Record));
+            }
+            ~ThreadBuffer()
+            {
+                memory::recordFree(MemoryTag::Logger, queue.capacity() * sizeof(Record));
+            }
+
+            SpscQueue<Record> queue;
+            std::atomic<bool> retired{false};  // the owning thread has exited
+            std::atomic<bool> orphaned{false}; // the logger has been destroyed
+        };
+
+        Logger::Logger(const std::string &filename, const LoggerConfig &config)
+            : m_overflow(config.overflow), m_encoding(config.encoding), m_capacity(config.capacity),
+              m_id(nextLoggerId.fetch_add(1, std::memory_order_relaxed))
+        {
+            // Checked here because thread buffers are only created on first use
+            if (m_capacity < 2 || (m_capacity & (m_capacity - 1)) != 0)
+            {
+                throw std::runtime_error("Logger capacity must be a power of two");
+            }
+            m_sink = std::make_unique<Sink>(filename, config);
+            m_baseTicks = logTicks();
+            m_baseSteadyNs = steadyNs();
+            m_baseWallNs = wallClockNs();
+            m_writer = std::thread([this]()
+                                   { writerLoop(); });
+        }
+
         Logger::~Logger()
         {
-            if (m_logFile.is_open())
+            m_stopping.store(true, std::memory_order_release);
+            m_wake.notifyAll();
+            m_writer.join();
+            m_sink.reset();
+
+            // Threads that logged here may outlive the logger; they drop their
+            // buffer the next time they look one up
+            std::lock_guard<std::mutex> lock(m_buffersMutex);
+            for (const std::shared_ptr<ThreadBuffer> &buffer : m_buffers)
             {
-                m_logFile.close();
+                buffer->orphaned.store(true, std::memory_order_release);
             }
         }
 
-        void Logger::log(const std::string &message, LogLevel level)
+        Logger::ThreadBuffer &Logger::threadBuffer()
         {
-            std::lock_guard<std::mutex> lock(m_logMutex);
-            if (m_logFile.is_open())
+            // This thread's buffers, one per logger it has used. A buffer is
+            // retired when its thread exits and freed once the writer has
+            // drained it.
+            struct Slot
+            {
+                Slot(uint64_t id, std::shared_ptr<ThreadBuffer> owned) : loggerId(id), buffer(std::move(owned)) {}
+                Slot(Slot &&) = default;
+                Slot &operator=(Slot &&) = default;
+                ~Slot()
+                {
+                    if (buffer)
+                    {
+                        buffer->retired.store(true, std::memory_order_release);
+                    }
+                }
+
+                uint64_t loggerId;
+                std::shared_ptr<ThreadBuffer> buffer;
+            };
+            thread_local std::vector<Slot> t_slots;
+
+            for (Slot &slot : t_slots)
             {
-                // m_logFile << timestamp() << " [" << levelToString(level) << "] " << message << std::endl;
-                // Also print to console if you want:
-                // std::cout << timestamp() << " [" << levelToString(level) << "] " << message << std::endl;
+                if (slot.loggerId == m_id)
+                {
+                    return *slot.buffer;
+                }
             }
+
+            t_slots.erase(std::remove_if(t_slots.begin(), t_slots.end(), [](const Slot &slot)
+                                         { return slot.buffer->orphaned.load(std::memory_order_acquire); }),
+                          t_slots.end());
+            std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>(m_capacity);
+            {
+                std::lock_guard<std::mutex> lock(m_buffersMutex);
+                m_buffers.push_back(buffer);
+            }
+            m_buffersVersion.fetch_add(1, std::memory_order_release);
+            t_slots.emplace_back(m_id, std::move(buffer));
+            return *t_slots.back().buffer;
+        }
+
+        void Logger::log(std::string_view message, LogLevel level)
+        {
+            Record record;
+            record.level = level;
+            record.length = static_cast<uint16_t>(std::min(message.size(), MaxMessageLength));
+            std::memcpy(record.text, message.data(), record.length);
+            submit(record);
         }
 
-        void Logger::logInfo(const std::string &message)
+        void Logger::logInfo(std::string_view message)
         {
             log(message, LogLevel::Info);
         }
 
-        void Logger::logWarning(const std::string &message)
+        void Logger::logWarning(std::string_view message)
         {
             log(message, LogLevel::Warning);
         }
 
-        void Logger::logError(const std::string &message)
+        void Logger::logError(std::string_view message)
         {
             log(message, LogLevel::Error);
         }
+
         void Logger::flush()
         {
-            std::lock_guard<std::mutex> lock(m_logMutex);
-            if (m_logFile.is_open())
+            // The writer merges the marker behind every record stamped before
+            // it, from any thread, so once it gets there they have all been
+            // written. Pushing under the lock keeps markers in ticket order.
+            Record marker;
+            marker.kind = RecordKind::Flush;
+            ThreadBuffer &buffer = threadBuffer();
+            std::unique_lock<std::mutex> lock(m_flushMutex);
+            marker.ticket = ++m_flushRequested;
+            pushBlocking(buffer, marker);
+            m_flushed.wait(lock, [this, &marker]()
+                           { return m_flushCompleted >= marker.ticket; });
+        }
+
+        void Logger::submit(Record &record)
+        {
+            ThreadBuffer &buffer = threadBuffer();
+            if (m_overflow == LogOverflow::Block)
+            {
+                pushBlocking(buffer, record);
+                return;
+            }
+            // Stamped as late as possible: the writer assumes a record shows
+            // up in its ring soon after its timestamp
+            record.ticks = logTicks();
+            if (!buffer.queue.tryPush(record))
+            {
+                if (m_overflow == LogOverflow::CountDropped)
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    m_droppedTotal.fetch_add(1, std::memory_order_relaxed);
+                }
+                return;
+            }
+            m_wake.notifyOne();
+        }
+
+        void Logger::pushBlocking(ThreadBuffer &buffer, Record &record)
+        {
+            for (;;)
+            {
+                // Restamped on every attempt so a long wait does not leave the
+                // record behind the writer's merge horizon
+                record.ticks = logTicks();
+                if (buffer.queue.tryPush(record))
+                {
+                    break;
+                }
+                m_wake.notifyOne();
+                std::this_thread::yield();
+            }
+            m_wake.notifyOne();
+        }
+
+        void Logger::writerLoop()
+        {
+            struct Source
+            {
+                std::shared_ptr<ThreadBuffer> buffer;
+                std::deque<Record> staged; // popped, waiting to be merged
+            };
+
+            std::string batch;
+            batch.reserve(WriteBatchBytes + 2 * MaxMessageLength);
+            EntryEncoder encoder(m_encoding);
+            TickConverter clock(m_baseTicks, m_baseSteadyNs, m_baseWallNs);
+            std::vector<Source> sources;
+            uint64_t buffersVersion = 0;
+            Record record;
+            bool wrote = false;
+
+            auto beginFile = [&]()
             {
-                m_logFile.flush();
+                if (m_encoding == LogEncoding::Binary && m_sink->size() == 0)
+                {
+                    batch.append(binarylog::Magic, sizeof(binarylog::Magic));
+                }
+            };
+            // Keeps entries whole within a file: one that would not fit is
+            // encoded again after rotating, with the Format entries and magic
+            // the new file needs
+            auto append = [&](auto &&encode)
+            {
+                size_t mark = batch.size();
+                encode();
+                if (batch.size() > m_sink->room())
+                {
+                    batch.resize(mark);
+                    m_sink->write(batch.data(), batch.size());
+                    batch.clear();
+                    m_sink->rotate();
+                    encoder = EntryEncoder(m_encoding);
+                    beginFile();
+                    encode();
+                }
+                if (batch.size() >= WriteBatchBytes)
+                {
+                    m_sink->write(batch.data(), batch.size());
+                    batch.clear();
+                    wrote = true;
+                }
+            };
+            beginFile();
+
+            for (;;)
+            {
+                bool stopping = m_stopping.load(std::memory_order_acquire);
+                uint64_t version = m_buffersVersion.load(std::memory_order_acquire);
+                if (version != buffersVersion)
+                {
+                    std::lock_guard<std::mutex> lock(m_buffersMutex);
+                    for (const std::shared_ptr<ThreadBuffer> &buffer : m_buffers)
+                    {
+                        bool known = std::any_of(sources.begin(), sources.end(), [&buffer](const Source &source)
+                                                 { return source.buffer == buffer; });
+                        if (!known)
+                        {
+                            sources.push_back({buffer, {}});
+                        }
+                    }
+                    buffersVersion = version;
+                }
+
+                // Taken before draining: a record stamped after the horizon
+                // could still have an earlier one in flight on another thread,
+                // so it waits for a later round. Only a thread stalled for
+                // longer than MergeGraceNs between stamping and pushing can
+                // land out of order.
+                clock.refine();
+                uint64_t horizon = stopping ? UINT64_MAX : logTicks() - clock.ticksFor(MergeGraceNs);
+                for (Source &source : sources)
+                {
+                    for (size_t i = 0; i < m_capacity && source.buffer->queue.tryPop(record); ++i)
+                    {
+                        source.staged.push_back(record);
+                    }
+                }
+
+                // Each ring is already in order, so merging means repeatedly
+                // taking the oldest head
+                uint64_t flushTicket = 0;
+                wrote = false;
+                for (;;)
+                {
+                    Source *oldest = nullptr;
+                    for (Source &source : sources)
+                    {
+                        if (!source.staged.empty() && source.staged.front().ticks <= horizon &&
+                            (!oldest || source.staged.front().ticks < oldest->staged.front().ticks))
+                        {
+                            oldest = &source;
+                        }
+                    }
+                    if (!oldest)
+                    {
+                        break;
+                    }
+
+                    const Record &next = oldest->staged.front();
+                    if (next.kind == RecordKind::Flush)
+                    {
+                        flushTicket = std::max(flushTicket, next.ticket);
+                    }
+                    else if (next.kind == RecordKind::Structured)
+                    {
+                        append([&]()
+                               { encoder.appendStructured(batch, *next.site, clock.toWallNs(next.ticks), next.text, next.length); });
+                    }
+                    else
+                    {
+                        append([&]()
+                               { encoder.appendMessage(batch, next.level, clock.toWallNs(next.ticks), std::string_view(next.text, next.length)); });
+                    }
+                    oldest->staged.pop_front();
+                }
+
+                uint64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+                if (dropped > 0)
+                {
+                    char args[16];
+                    size_t used = 0;
+                    binarylog::pack(args, sizeof(args), used, dropped);
+                    uint64_t timeNs = wallClockNs();
+                    append([&]()
+                           { encoder.appendStructured(batch, DroppedSite, timeNs, args, used); });
+                }
+                if (!batch.empty())
+                {
+                    m_sink->write(batch.data(), batch.size());
+                    batch.clear();
+                    wrote = true;
+                }
+                if (wrote)
+                {
+                    m_sink->flush();
+                }
+                if (flushTicket != 0)
+                {
+                    m_sink->sync();
+                    {
+                        std::lock_guard<std::mutex> lock(m_flushMutex);
+                        m_flushCompleted = flushTicket;
+                    }
+                    m_flushed.notify_all();
+                }
+
+                // Free the buffers of exited threads once drained. retired is
+                // read first: the thread's last push happens before it is set.
+                bool queued = false;
+                bool held = false;
+                for (size_t i = 0; i < sources.size();)
+                {
+                    Source &source = sources[i];
+                    bool retired = source.buffer->retired.load(std::memory_order_acquire);
+                    bool empty = source.buffer->queue.sizeApprox() == 0;
+                    if (retired && empty && source.staged.empty())
+                    {
+                        std::lock_guard<std::mutex> lock(m_buffersMutex);
+                        m_buffers.erase(std::find(m_buffers.begin(), m_buffers.end(), source.buffer));
+                        sources.erase(sources.begin() + static_cast<std::ptrdiff_t>(i));
+                        continue;
+                    }
+                    queued = queued || !empty;
+                    held = held || !source.staged.empty();
+                    ++i;
+                }
+
+                if (queued)
+                {
+                    continue;
+                }
+                if (held)
+                {
+                    // Records younger than the horizon; they will pass it shortly
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(MergeGraceNs / 2));
+                    continue;
+                }
+                if (stopping)
+                {
+                    return;
+                }
+
+                uint32_t key = m_wake.prepareWait();
+                bool ready = m_stopping.load(std::memory_order_acquire) ||
+                             m_buffersVersion.load(std::memory_order_acquire) != buffersVersion ||
+                             std::any_of(sources.begin(), sources.end(), [](const Source &source)
+                                         { return source.buffer->queue.sizeApprox() > 0; });
+                if (ready)
+                {
+                    m_wake.cancelWait();
+                }
+                else
+                {
+                    m_wake.commitWait(key);
+                }
             }
         }
     }
-}
\ No newline at end of file
+}
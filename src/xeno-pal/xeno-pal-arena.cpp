@@ -1,39 +1,233 @@
 #include "xeno-pal.hpp"
+#include <cstdint>
 #include <stdexcept>
 
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace xeno
 {
     namespace pal
     {
-        Arena::Arena(size_t size)
-            : m_size(size), m_offset(0)
+        namespace
+        {
+            size_t pageSize()
+            {
+#if defined(_WIN32)
+                SYSTEM_INFO info;
+                GetSystemInfo(&info);
+                return static_cast<size_t>(info.dwPageSize);
+#else
+                return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+            }
+
+            size_t roundUp(size_t value, size_t multiple)
+            {
+                return ((value + multiple - 1) / multiple) * multiple;
+            }
+
+            char *reserveAddressSpace(size_t size)
+            {
+#if defined(_WIN32)
+                return static_cast<char *>(VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS));
+#else
+                void *ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+                return ptr == MAP_FAILED ? nullptr : static_cast<char *>(ptr);
+#endif
+            }
+
+            void releaseAddressSpace(char *base, size_t size)
+            {
+#if defined(_WIN32)
+                (void)size;
+                VirtualFree(base, 0, MEM_RELEASE);
+#else
+                munmap(base, size);
+#endif
+            }
+
+            bool commitPages(char *address, size_t size)
+            {
+#if defined(_WIN32)
+                return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+                return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+            }
+
+            void decommitPages(char *address, size_t size)
+            {
+#if defined(_WIN32)
+                VirtualFree(address, size, MEM_DECOMMIT);
+#else
+                // Drop the physical pages, then make the range inaccessible again
+                madvise(address, size, MADV_DONTNEED);
+                mprotect(address, size, PROT_NONE);
+#endif
+            }
+        }
+
+        Arena::Arena(size_t size, MemoryTag tag)
+            : m_size(size), m_offset(0), m_highWater(0), m_committed(size), m_tag(tag)
         {
             m_memory = reinterpret_cast<char *>(new char[size]);
             if (!m_memory)
             {
                 throw std::runtime_error("Failed to allocate memory for arena");
             }
+            memory::recordAllocation(m_tag, m_size);
+        }
+
+        Arena::Arena(const VirtualConfig &config)
+            : m_offset(0), m_highWater(0), m_committed(0), m_tag(config.tag), m_virtual(true)
+        {
+            if (config.reserveSize == 0)
+            {
+                throw std::runtime_error("Virtual arena needs a non-zero reserveSize");
+            }
+            size_t page = pageSize();
+            m_size = roundUp(config.reserveSize, page);
+            m_commitChunk = roundUp(config.commitChunk > 0 ? config.commitChunk : page, page);
+            m_retainOnReset = roundUp(config.retainOnReset, page);
+
+            m_memory = reserveAddressSpace(m_size);
+            if (!m_memory)
+            {
+                throw std::runtime_error("Failed to reserve address space for arena");
+            }
         }
 
         Arena::~Arena()
         {
-            delete[] m_memory;
+            memory::recordFree(m_tag, m_committed);
+            if (m_virtual)
+            {
+                releaseAddressSpace(m_memory, m_size);
+            }
+            else
+            {
+                delete[] m_memory;
+            }
         }
 
-        void *Arena::allocate(size_t size)
+        void *Arena::allocate(size_t size, size_t alignment)
         {
-            if (m_offset + size > m_size)
+            if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+            {
+                throw std::runtime_error("Arena alignment must be a power of two");
+            }
+
+            // Align the absolute address so over-aligned requests (SIMD, GPU
+            // upload structs) are honoured regardless of the base alignment.
+            uintptr_t base = reinterpret_cast<uintptr_t>(m_memory);
+            uintptr_t current = base + m_offset;
+            uintptr_t aligned = (current + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1);
+            size_t offset = static_cast<size_t>(aligned - base);
+
+            if (offset > m_size || size > m_size - offset)
             {
                 throw std::runtime_error("Arena memory exhausted");
             }
-            void *ptr = m_memory + m_offset;
-            m_offset += size;
-            return ptr;
+            if (offset + size > m_committed)
+            {
+                commit(offset + size);
+            }
+            m_offset = offset + size;
+            if (m_offset > m_highWater)
+            {
+                m_highWater = m_offset;
+            }
+            return m_memory + offset;
+        }
+
+        void Arena::rewind(Marker marker)
+        {
+            if (marker.offset > m_offset)
+            {
+                throw std::runtime_error("Arena marker is newer than the current offset");
+            }
+            m_offset = marker.offset;
+        }
+
+        void Arena::unwind(Marker marker) noexcept
+        {
+            if (marker.offset < m_offset)
+            {
+                m_offset = marker.offset;
+            }
         }
 
         void Arena::reset()
         {
             m_offset = 0;
+            if (m_virtual && m_committed > m_retainOnReset)
+            {
+                decommit(m_retainOnReset);
+            }
+        }
+
+        void Arena::commit(size_t required)
+        {
+            size_t target = roundUp(required, m_commitChunk);
+            if (target > m_size)
+            {
+                target = m_size;
+            }
+            if (!commitPages(m_memory + m_committed, target - m_committed))
+            {
+                throw std::runtime_error("Failed to commit arena memory");
+            }
+            memory::recordAllocation(m_tag, target - m_committed);
+            m_committed = target;
+        }
+
+        void Arena::decommit(size_t keep)
+        {
+            decommitPages(m_memory + keep, m_committed - keep);
+            memory::recordFree(m_tag, m_committed - keep);
+            m_committed = keep;
+        }
+
+        Arena &scratch()
+        {
+            thread_local std::unique_ptr<Arena> arena = []()
+            {
+                Arena::VirtualConfig config;
+                config.reserveSize = 256 * 1024 * 1024;
+                config.retainOnReset = 4 * 1024 * 1024;
+                config.tag = MemoryTag::Scratch;
+                return std::make_unique<Arena>(config);
+            }();
+            return *arena;
+        }
+
+        FrameArenas::FrameArenas(uint32_t frameCount, const Arena::VirtualConfig &config)
+        {
+            if (frameCount == 0)
+            {
+                throw std::runtime_error("FrameArenas needs at least one frame");
+            }
+            m_arenas.reserve(frameCount);
+            for (uint32_t i = 0; i < frameCount; ++i)
+            {
+                m_arenas.push_back(std::make_unique<Arena>(config));
+            }
+        }
+
+        void FrameArenas::beginFrame(uint32_t frameIndex)
+        {
+            if (frameIndex >= m_arenas.size())
+            {
+                throw std::runtime_error("Frame index out of range");
+            }
+            m_frameIndex = frameIndex;
+            m_arenas[frameIndex]->reset();
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,68 @@
+#include "xeno-pal-coroutine.hpp"
+#include <fstream>
+#include <stdexcept>
+
+namespace xeno
+{
+    namespace pal
+    {
+        void MainThreadQueue::post(InlineTask task)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(std::move(task));
+        }
+
+        size_t MainThreadQueue::runPending()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::swap(m_pending, m_running);
+            }
+            for (InlineTask &task : m_running)
+            {
+                task();
+            }
+            size_t count = m_running.size();
+            // Keeps its capacity, so steady-state frames do not allocate here
+            m_running.clear();
+            return count;
+        }
+
+        void FileReadAwaiter::await_suspend(std::coroutine_handle<> handle)
+        {
+            m_pool.dispatchIo([this, handle]()
+                              {
+                try
+                {
+                    std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+                    if (!file.is_open())
+                    {
+                        throw std::runtime_error("Failed to open file: " + m_path);
+                    }
+                    std::streamsize size = file.tellg();
+                    file.seekg(0);
+                    m_data.resize(static_cast<size_t>(size));
+                    if (!file.read(m_data.data(), size))
+                    {
+                        throw std::runtime_error("Failed to read file: " + m_path);
+                    }
+                }
+                catch (...)
+                {
+                    m_error = std::current_exception();
+                }
+                // Decoding and the rest of the coroutine belong on a worker, not the I/O thread
+                m_pool.dispatch([handle]()
+                                { handle.resume(); }); });
+        }
+
+        std::vector<char> FileReadAwaiter::await_resume()
+        {
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+            return std::move(m_data);
+        }
+    }
+}
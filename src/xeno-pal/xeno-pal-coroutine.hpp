@@ -0,0 +1,354 @@
+#pragma once
+
+#include "xeno-pal.hpp"
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xeno
+{
+    namespace pal
+    {
+        template <typename T = void>
+        class Task;
+
+        namespace detail
+        {
+            struct PromiseBase
+            {
+                // Resumes whoever awaited this task once it finishes, without
+                // growing the stack (symmetric transfer)
+                struct FinalAwaiter
+                {
+                    bool await_ready() noexcept { return false; }
+
+                    template <typename Promise>
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                    {
+                        std::coroutine_handle<> continuation = handle.promise().continuation;
+                        return continuation ? continuation : std::noop_coroutine();
+                    }
+
+                    void await_resume() noexcept {}
+                };
+
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                FinalAwaiter final_suspend() noexcept { return {}; }
+                void unhandled_exception() { error = std::current_exception(); }
+
+                std::coroutine_handle<> continuation;
+                std::exception_ptr error;
+            };
+
+            template <typename T>
+            struct Promise : PromiseBase
+            {
+                Task<T> get_return_object();
+
+                template <typename U>
+                void return_value(U &&result)
+                {
+                    value.emplace(std::forward<U>(result));
+                }
+
+                T result()
+                {
+                    if (error)
+                    {
+                        std::rethrow_exception(error);
+                    }
+                    return std::move(*value);
+                }
+
+                std::optional<T> value;
+            };
+
+            template <>
+            struct Promise<void> : PromiseBase
+            {
+                Task<void> get_return_object();
+                void return_void() {}
+
+                void result()
+                {
+                    if (error)
+                    {
+                        std::rethrow_exception(error);
+                    }
+                }
+            };
+        }
+
+        // Lazily started coroutine. Nothing runs until the task is co_awaited
+        // (or handed to spawn()), and the awaiting coroutine is resumed on
+        // whichever thread the task finishes on. Allocations from scratch() do
+        // not survive a co_await, since the pool rewinds it after each resume.
+        template <typename T>
+        class [[nodiscard]] Task
+        {
+        public:
+            using promise_type = detail::Promise<T>;
+
+            Task() = default;
+            Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+            Task &operator=(Task &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    if (m_handle)
+                    {
+                        m_handle.destroy();
+                    }
+                    m_handle = std::exchange(other.m_handle, nullptr);
+                }
+                return *this;
+            }
+            Task(const Task &) = delete;
+            Task &operator=(const Task &) = delete;
+            ~Task()
+            {
+                if (m_handle)
+                {
+                    m_handle.destroy();
+                }
+            }
+
+            bool valid() const { return static_cast<bool>(m_handle); }
+            bool isReady() const { return m_handle && m_handle.done(); }
+
+            auto operator co_await() && noexcept
+            {
+                struct Awaiter
+                {
+                    std::coroutine_handle<promise_type> handle;
+
+                    bool await_ready() noexcept { return !handle || handle.done(); }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                    {
+                        handle.promise().continuation = awaiting;
+                        return handle;
+                    }
+
+                    T await_resume() { return handle.promise().result(); }
+                };
+                return Awaiter{m_handle};
+            }
+
+        private:
+            friend struct detail::Promise<T>;
+
+            explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+            std::coroutine_handle<promise_type> m_handle;
+        };
+
+        namespace detail
+        {
+            template <typename T>
+            Task<T> Promise<T>::get_return_object()
+            {
+                return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+            }
+
+            inline Task<void> Promise<void>::get_return_object()
+            {
+                return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+            }
+        }
+
+        // Work that must run on the main thread, such as swapping streamed
+        // assets into the scene. The engine calls runPending() once per frame;
+        // anything posted while it runs waits for the next frame.
+        class MainThreadQueue
+        {
+        public:
+            void post(InlineTask task);
+
+            template <typename F>
+            void post(F &&f)
+            {
+                post(makeTask(std::forward<F>(f)));
+            }
+
+            // Returns the number of tasks run
+            size_t runPending();
+
+        private:
+            std::mutex m_mutex;
+            std::vector<InlineTask> m_pending;
+            std::vector<InlineTask> m_running;
+        };
+
+        // co_await resumeOn(pool) continues the coroutine on a pool worker
+        class ResumeOnPool
+        {
+        public:
+            ResumeOnPool(ThreadPool &pool, TaskPriority priority) : m_pool(pool), m_priority(priority) {}
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_pool.dispatch(m_priority, [handle]()
+                                { handle.resume(); });
+            }
+            void await_resume() const noexcept {}
+
+        private:
+            ThreadPool &m_pool;
+            TaskPriority m_priority;
+        };
+
+        inline ResumeOnPool resumeOn(ThreadPool &pool, TaskPriority priority = TaskPriority::Normal)
+        {
+            return ResumeOnPool(pool, priority);
+        }
+
+        // co_await nextFrame(queue) continues the coroutine on the main thread
+        // during the next MainThreadQueue::runPending()
+        class ResumeNextFrame
+        {
+        public:
+            explicit ResumeNextFrame(MainThreadQueue &queue) : m_queue(queue) {}
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_queue.post([handle]()
+                             { handle.resume(); });
+            }
+            void await_resume() const noexcept {}
+
+        private:
+            MainThreadQueue &m_queue;
+        };
+
+        inline ResumeNextFrame nextFrame(MainThreadQueue &queue)
+        {
+            return ResumeNextFrame(queue);
+        }
+
+        // co_await waitUntil(queue, ready) checks ready() once per frame on the
+        // main thread, starting next frame, and continues there the first frame
+        // it returns true. Suits things that can only be polled, like GPU fences.
+        template <typename Predicate>
+        class FramePoll
+        {
+        public:
+            FramePoll(MainThreadQueue &queue, Predicate ready) : m_queue(queue), m_ready(std::move(ready)) {}
+
+            // ready() is only ever called on the main thread
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_handle = handle;
+                schedule();
+            }
+            void await_resume() const noexcept {}
+
+        private:
+            void schedule()
+            {
+                m_queue.post([this]()
+                             {
+                    if (m_ready())
+                    {
+                        m_handle.resume();
+                    }
+                    else
+                    {
+                        schedule();
+                    } });
+            }
+
+            MainThreadQueue &m_queue;
+            Predicate m_ready;
+            std::coroutine_handle<> m_handle;
+        };
+
+        template <typename Predicate>
+        FramePoll<std::decay_t<Predicate>> waitUntil(MainThreadQueue &queue, Predicate &&ready)
+        {
+            return FramePoll<std::decay_t<Predicate>>(queue, std::forward<Predicate>(ready));
+        }
+
+        // co_await readFileAsync(pool, path) reads the whole file on one of the
+        // pool's I/O threads and continues on a worker with its contents.
+        // Throws std::runtime_error if the file cannot be read.
+        class FileReadAwaiter
+        {
+        public:
+            FileReadAwaiter(ThreadPool &pool, std::string path) : m_pool(pool), m_path(std::move(path)) {}
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle);
+            std::vector<char> await_resume();
+
+        private:
+            ThreadPool &m_pool;
+            std::string m_path;
+            std::vector<char> m_data;
+            std::exception_ptr m_error;
+        };
+
+        inline FileReadAwaiter readFileAsync(ThreadPool &pool, std::string path)
+        {
+            return FileReadAwaiter(pool, std::move(path));
+        }
+
+        namespace detail
+        {
+            struct Detached
+            {
+                struct promise_type
+                {
+                    Detached get_return_object() noexcept { return {}; }
+                    std::suspend_never initial_suspend() noexcept { return {}; }
+                    std::suspend_never final_suspend() noexcept { return {}; }
+                    void return_void() noexcept {}
+                    void unhandled_exception() noexcept { std::terminate(); }
+                };
+            };
+
+            template <typename T>
+            Detached runDetached(ThreadPool &pool, TaskPriority priority, Task<T> task, std::shared_ptr<TaskState<T>> state)
+            {
+                co_await resumeOn(pool, priority);
+                try
+                {
+                    if constexpr (std::is_void_v<T>)
+                    {
+                        co_await std::move(task);
+                    }
+                    else
+                    {
+                        state->value.emplace(co_await std::move(task));
+                    }
+                }
+                catch (...)
+                {
+                    state->error = std::current_exception();
+                }
+                state->ready.store(true, std::memory_order_release);
+            }
+        }
+
+        // Starts a coroutine on the pool. The handle can be polled with
+        // isReady() or waited on like any other task.
+        template <typename T>
+        TaskHandle<T> spawn(ThreadPool &pool, Task<T> task, TaskPriority priority = TaskPriority::Normal)
+        {
+            std::shared_ptr<TaskState<T>> state = std::make_shared<TaskState<T>>();
+            detail::runDetached(pool, priority, std::move(task), state);
+            return TaskHandle<T>(&pool, std::move(state), ThreadPool::helpLaneFor(priority));
+        }
+    }
+
+    template <typename T = void>
+    using Task = pal::Task<T>;
+}
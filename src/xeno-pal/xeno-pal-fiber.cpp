@@ -0,0 +1,601 @@
+#if defined(__APPLE__)
+// ucontext is only declared for XSI conformance on macOS
+#define _XOPEN_SOURCE 600
+#endif
+
+#include "xeno-pal-fiber.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define XENO_ASAN_FIBERS 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define XENO_ASAN_FIBERS 1
+#endif
+#endif
+
+#if defined(__SANITIZE_THREAD__)
+#define XENO_TSAN_FIBERS 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define XENO_TSAN_FIBERS 1
+#endif
+#endif
+
+#if defined(XENO_ASAN_FIBERS)
+#include <sanitizer/common_interface_defs.h>
+#endif
+#if defined(XENO_TSAN_FIBERS)
+#include <sanitizer/tsan_interface.h>
+#endif
+
+#if defined(_MSC_VER)
+#define XENO_NOINLINE __declspec(noinline)
+#else
+#define XENO_NOINLINE __attribute__((noinline))
+#endif
+
+namespace xeno
+{
+    namespace pal
+    {
+        namespace
+        {
+            constexpr size_t InjectionQueueCapacity = 4096;
+            constexpr size_t FreeJobCapacity = 4096;
+            constexpr size_t FreeFiberCapacity = 1024;
+            constexpr int IdleSpins = 64;
+
+            struct Context
+            {
+#if defined(_WIN32)
+                void *fiber = nullptr;
+#else
+                ucontext_t context;
+#endif
+#if defined(XENO_TSAN_FIBERS)
+                void *tsanFiber = nullptr;
+#endif
+                // Stack bounds for ASan. A thread's own stack is learned the
+                // first time one of its fibers is entered.
+                const void *stackBottom = nullptr;
+                size_t stackSize = 0;
+            };
+
+            struct ThreadState
+            {
+                enum class After
+                {
+                    Nothing,
+                    Release, // the fiber finished its jobs and can be reused
+                    Park     // the fiber is waiting on parkOn
+                };
+
+                Context scheduler; // this thread's own stack
+                bool schedulerReady = false;
+                const FiberJobSystem *system = nullptr; // set on worker threads
+                void *worker = nullptr;
+                void *current = nullptr;    // fiber running on this thread
+                void *pendingJob = nullptr; // handed to a fiber as it is switched to
+                After after = After::Nothing;
+                JobCounter *parkOn = nullptr;
+            };
+
+            // Fibers migrate between threads, so code running on one must look
+            // its thread state up again after every switch. The out-of-line
+            // call plus the compiler barrier stop the thread_local's address
+            // from being cached across a switch.
+            XENO_NOINLINE ThreadState &threadState()
+            {
+                thread_local ThreadState state;
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+                return state;
+            }
+
+            void prepareScheduler(ThreadState &state)
+            {
+                if (state.schedulerReady)
+                {
+                    return;
+                }
+#if defined(_WIN32)
+                state.scheduler.fiber = IsThreadAFiber() ? GetCurrentFiber() : ConvertThreadToFiber(nullptr);
+#endif
+#if defined(XENO_TSAN_FIBERS)
+                state.scheduler.tsanFiber = __tsan_get_current_fiber();
+#endif
+                state.schedulerReady = true;
+            }
+
+            // Saves the running context into `from` and continues `to`. When a
+            // fiber is resumed it may be on another thread, whose stack bounds
+            // are learned here for ASan when learnScheduler is set.
+            void switchContext(Context &from, Context &to, bool learnScheduler)
+            {
+#if defined(XENO_ASAN_FIBERS)
+                void *fakeStack = nullptr;
+                __sanitizer_start_switch_fiber(&fakeStack, to.stackBottom, to.stackSize);
+#endif
+#if defined(XENO_TSAN_FIBERS)
+                __tsan_switch_to_fiber(to.tsanFiber, 0);
+#endif
+#if defined(_WIN32)
+                SwitchToFiber(to.fiber);
+#else
+                swapcontext(&from.context, &to.context);
+#endif
+#if defined(XENO_ASAN_FIBERS)
+                const void *bottom = nullptr;
+                size_t size = 0;
+                __sanitizer_finish_switch_fiber(fakeStack, &bottom, &size);
+                if (learnScheduler)
+                {
+                    threadState().scheduler.stackBottom = bottom;
+                    threadState().scheduler.stackSize = size;
+                }
+#else
+                (void)learnScheduler;
+#endif
+            }
+        }
+
+        struct FiberJobSystem::Fiber
+        {
+            FiberJobSystem *system = nullptr;
+            Context context;
+            void *mapping = nullptr;
+            size_t mappingSize = 0;
+        };
+
+        struct FiberJobSystem::Worker
+        {
+            WorkStealingDeque<Job *> deque;
+            std::thread thread;
+            uint64_t rng;
+        };
+
+        FiberJobSystem::FiberJobSystem(const FiberJobSystemConfig &config)
+            : m_config(config), m_injection(InjectionQueueCapacity), m_freeJobs(FreeJobCapacity), m_freeFibers(FreeFiberCapacity)
+        {
+            size_t numThreads = config.workerThreads == 0 ? 1 : config.workerThreads;
+            for (size_t i = 0; i < std::min(config.initialFibers, FreeFiberCapacity); ++i)
+            {
+                m_freeFibers.tryPush(createFiber());
+            }
+
+            m_workers.reserve(numThreads);
+            for (size_t i = 0; i < numThreads; ++i)
+            {
+                m_workers.push_back(std::make_unique<Worker>());
+                m_workers.back()->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+            }
+            for (std::unique_ptr<Worker> &worker : m_workers)
+            {
+                Worker *self = worker.get();
+                worker->thread = std::thread([this, self]()
+                                             { workerLoop(self); });
+            }
+        }
+
+        FiberJobSystem::~FiberJobSystem()
+        {
+            m_stopping.store(true);
+            m_idle.notifyAll();
+            for (std::unique_ptr<Worker> &worker : m_workers)
+            {
+                worker->thread.join();
+            }
+
+            Job *job = nullptr;
+            while (m_freeJobs.tryPop(job))
+            {
+                delete job;
+            }
+            // Fibers still parked here belong to counters nobody waited on
+            for (Fiber *fiber : m_fibers)
+            {
+                destroyFiber(fiber);
+            }
+        }
+
+        void FiberJobSystem::submit(InlineTask function, JobCounter *counter)
+        {
+            Job *job = allocateJob();
+            job->function = std::move(function);
+            job->counter = counter;
+            if (counter)
+            {
+                counter->m_value.fetch_add(1, std::memory_order_acq_rel);
+            }
+
+            ThreadState &state = threadState();
+            if (state.system == this)
+            {
+                static_cast<Worker *>(state.worker)->deque.push(job);
+            }
+            else if (!m_injection.tryPush(job))
+            {
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                m_overflow.push_back(job);
+                m_overflowSize.fetch_add(1);
+            }
+            m_idle.notifyOne();
+        }
+
+        void FiberJobSystem::waitFor(JobCounter &counter)
+        {
+            ThreadState &state = threadState();
+            Fiber *current = static_cast<Fiber *>(state.current);
+            if (current && current->system == this)
+            {
+                if (counter.value() == 0)
+                {
+                    // The last decrement happens under the lock; taking it here
+                    // means the decrementer is done with the counter
+                    std::lock_guard<std::mutex> lock(counter.m_mutex);
+                    return;
+                }
+                state.after = ThreadState::After::Park;
+                state.parkOn = &counter;
+                switchContext(current->context, state.scheduler, true);
+                return;
+            }
+
+            while (counter.value() != 0)
+            {
+                std::this_thread::yield();
+            }
+            std::lock_guard<std::mutex> lock(counter.m_mutex);
+        }
+
+        void FiberJobSystem::fiberMain(Fiber *self)
+        {
+#if defined(XENO_ASAN_FIBERS)
+            __sanitizer_finish_switch_fiber(nullptr, &threadState().scheduler.stackBottom, &threadState().scheduler.stackSize);
+#endif
+            FiberJobSystem &system = *self->system;
+            for (;;)
+            {
+                Job *job = static_cast<Job *>(threadState().pendingJob);
+                threadState().pendingJob = nullptr;
+                while (job)
+                {
+                    system.execute(job);
+                    // Stay on this fiber while nothing parked is waiting to be resumed
+                    job = system.m_readySize.load(std::memory_order_relaxed) == 0
+                              ? system.findJob(static_cast<Worker *>(threadState().worker))
+                              : nullptr;
+                }
+
+                ThreadState &state = threadState();
+                state.after = ThreadState::After::Release;
+                switchContext(self->context, state.scheduler, true);
+            }
+        }
+
+        FiberJobSystem::Job *FiberJobSystem::allocateJob()
+        {
+            Job *job = nullptr;
+            if (m_freeJobs.tryPop(job))
+            {
+                return job;
+            }
+            return new Job();
+        }
+
+        void FiberJobSystem::releaseJob(Job *job)
+        {
+            job->function.reset();
+            job->counter = nullptr;
+            if (!m_freeJobs.tryPush(job))
+            {
+                delete job;
+            }
+        }
+
+        FiberJobSystem::Fiber *FiberJobSystem::acquireFiber()
+        {
+            Fiber *fiber = nullptr;
+            if (m_freeFibers.tryPop(fiber))
+            {
+                return fiber;
+            }
+            return createFiber();
+        }
+
+        FiberJobSystem::Fiber *FiberJobSystem::createFiber()
+        {
+            std::unique_ptr<Fiber> fiber = std::make_unique<Fiber>();
+            fiber->system = this;
+#if defined(_WIN32)
+            fiber->context.fiber = CreateFiber(m_config.stackSize, [](void *parameter)
+                                               { fiberMain(static_cast<Fiber *>(parameter)); }, fiber.get());
+            if (!fiber->context.fiber)
+            {
+                throw std::runtime_error("Failed to create fiber");
+            }
+            fiber->mappingSize = m_config.stackSize;
+#else
+            size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            size_t stackSize = (m_config.stackSize + page - 1) / page * page;
+            fiber->mappingSize = stackSize + page;
+            fiber->mapping = mmap(nullptr, fiber->mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (fiber->mapping == MAP_FAILED)
+            {
+                throw std::runtime_error("Failed to allocate fiber stack");
+            }
+            // Stacks grow down, so the guard page goes at the low end
+            mprotect(fiber->mapping, page, PROT_NONE);
+
+            ucontext_t &context = fiber->context.context;
+            getcontext(&context);
+            context.uc_stack.ss_sp = static_cast<char *>(fiber->mapping) + page;
+            context.uc_stack.ss_size = stackSize;
+            context.uc_link = nullptr;
+            makecontext(&context, []()
+                        { fiberMain(static_cast<Fiber *>(threadState().current)); }, 0);
+            fiber->context.stackBottom = context.uc_stack.ss_sp;
+            fiber->context.stackSize = stackSize;
+#endif
+#if defined(XENO_TSAN_FIBERS)
+            fiber->context.tsanFiber = __tsan_create_fiber(0);
+#endif
+            memory::recordAllocation(MemoryTag::Tasks, fiber->mappingSize);
+
+            std::lock_guard<std::mutex> lock(m_fibersMutex);
+            m_fibers.push_back(fiber.get());
+            m_fibersCreated.fetch_add(1, std::memory_order_relaxed);
+            return fiber.release();
+        }
+
+        void FiberJobSystem::destroyFiber(Fiber *fiber)
+        {
+#if defined(XENO_TSAN_FIBERS)
+            __tsan_destroy_fiber(fiber->context.tsanFiber);
+#endif
+#if defined(_WIN32)
+            DeleteFiber(fiber->context.fiber);
+#else
+            munmap(fiber->mapping, fiber->mappingSize);
+#endif
+            memory::recordFree(MemoryTag::Tasks, fiber->mappingSize);
+            delete fiber;
+        }
+
+        void FiberJobSystem::releaseFiber(Fiber *fiber)
+        {
+            if (m_freeFibers.tryPush(fiber))
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_fibersMutex);
+                m_fibers.erase(std::find(m_fibers.begin(), m_fibers.end(), fiber));
+            }
+            destroyFiber(fiber);
+        }
+
+        // Runs on the scheduler after the fiber has switched away, so nobody can
+        // resume it while its stack is still in use
+        void FiberJobSystem::parkFiber(Fiber *fiber, JobCounter &counter)
+        {
+            {
+                std::lock_guard<std::mutex> lock(counter.m_mutex);
+                if (counter.m_value.load(std::memory_order_acquire) != 0)
+                {
+                    counter.m_waiters.push_back(fiber);
+                    return;
+                }
+            }
+            makeReady(fiber);
+        }
+
+        void FiberJobSystem::makeReady(Fiber *fiber)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_readyMutex);
+                m_ready.push_back(fiber);
+                m_readySize.fetch_add(1);
+            }
+            m_idle.notifyOne();
+        }
+
+        FiberJobSystem::Job *FiberJobSystem::findJob(Worker *self)
+        {
+            Job *job = nullptr;
+            if (self->deque.pop(job) || m_injection.tryPop(job))
+            {
+                return job;
+            }
+
+            if (m_overflowSize.load(std::memory_order_relaxed) > 0)
+            {
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                if (!m_overflow.empty())
+                {
+                    job = m_overflow.front();
+                    m_overflow.pop_front();
+                    m_overflowSize.fetch_sub(1);
+                    return job;
+                }
+            }
+
+            uint64_t &rng = self->rng;
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            size_t count = m_workers.size();
+            size_t start = static_cast<size_t>(rng % count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                Worker *victim = m_workers[(start + i) % count].get();
+                if (victim != self && victim->deque.steal(job))
+                {
+                    return job;
+                }
+            }
+            return nullptr;
+        }
+
+        bool FiberJobSystem::hasVisibleWork() const
+        {
+            if (m_readySize.load() > 0 || m_injection.sizeApprox() > 0 || m_overflowSize.load() > 0)
+            {
+                return true;
+            }
+            for (const std::unique_ptr<Worker> &worker : m_workers)
+            {
+                if (worker->deque.sizeApprox() > 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // One scheduling step on the calling thread: resume a fiber whose wait
+        // is over, or start a job on a pooled fiber
+        bool FiberJobSystem::runOne(Worker *self)
+        {
+            ThreadState &state = threadState();
+            prepareScheduler(state);
+
+            Fiber *fiber = nullptr;
+            if (m_readySize.load(std::memory_order_relaxed) > 0)
+            {
+                std::lock_guard<std::mutex> lock(m_readyMutex);
+                if (!m_ready.empty())
+                {
+                    fiber = m_ready.front();
+                    m_ready.pop_front();
+                    m_readySize.fetch_sub(1);
+                }
+            }
+            if (!fiber)
+            {
+                Job *job = findJob(self);
+                if (!job)
+                {
+                    return false;
+                }
+                fiber = acquireFiber();
+                state.pendingJob = job;
+            }
+
+            state.current = fiber;
+            switchContext(state.scheduler, fiber->context, false);
+
+            // Back on this thread's own stack; the fiber says why it stopped
+            ThreadState::After after = state.after;
+            JobCounter *parkOn = state.parkOn;
+            state.current = nullptr;
+            state.after = ThreadState::After::Nothing;
+            state.parkOn = nullptr;
+            if (after == ThreadState::After::Release)
+            {
+                releaseFiber(fiber);
+            }
+            else if (after == ThreadState::After::Park)
+            {
+                parkFiber(fiber, *parkOn);
+            }
+            return true;
+        }
+
+        void FiberJobSystem::execute(Job *job)
+        {
+            try
+            {
+                job->function();
+            }
+            catch (...)
+            {
+                // Unwinding cannot cross a fiber switch
+                std::terminate();
+            }
+
+            JobCounter *counter = job->counter;
+            releaseJob(job);
+            if (!counter)
+            {
+                return;
+            }
+
+            // Only the decrement to zero takes the lock, so a waiter that sees
+            // zero and then takes the lock knows this thread is done with it
+            int64_t value = counter->m_value.load(std::memory_order_relaxed);
+            while (value > 1)
+            {
+                if (counter->m_value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    return;
+                }
+            }
+            std::vector<void *> waiters;
+            {
+                std::lock_guard<std::mutex> lock(counter->m_mutex);
+                if (counter->m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    waiters.swap(counter->m_waiters);
+                }
+            }
+            for (void *waiter : waiters)
+            {
+                makeReady(static_cast<Fiber *>(waiter));
+            }
+        }
+
+        void FiberJobSystem::workerLoop(Worker *self)
+        {
+            ThreadState &state = threadState();
+            state.system = this;
+            state.worker = self;
+
+            for (;;)
+            {
+                if (runOne(self))
+                {
+                    continue;
+                }
+
+                bool found = false;
+                for (int i = 0; i < IdleSpins && !found; ++i)
+                {
+                    cpuRelax();
+                    found = hasVisibleWork();
+                }
+                if (found)
+                {
+                    continue;
+                }
+
+                uint32_t key = m_idle.prepareWait();
+                if (hasVisibleWork())
+                {
+                    m_idle.cancelWait();
+                    continue;
+                }
+                if (m_stopping.load())
+                {
+                    m_idle.cancelWait();
+                    break;
+                }
+                m_idle.commitWait(key);
+            }
+
+            state.system = nullptr;
+            state.worker = nullptr;
+        }
+    }
+}
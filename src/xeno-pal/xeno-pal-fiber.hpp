@@ -0,0 +1,132 @@
+#pragma once
+
+#include "xeno-pal.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xeno
+{
+    namespace pal
+    {
+        class FiberJobSystem;
+
+        // Number of outstanding jobs. A job waiting on a counter parks its fiber
+        // instead of blocking the worker thread, so however deep fork/join
+        // recursion goes, every worker keeps running jobs.
+        class JobCounter
+        {
+        public:
+            JobCounter() = default;
+            JobCounter(const JobCounter &) = delete;
+            JobCounter &operator=(const JobCounter &) = delete;
+
+            int64_t value() const { return m_value.load(std::memory_order_acquire); }
+            bool isDone() const { return value() == 0; }
+
+        private:
+            friend class FiberJobSystem;
+
+            std::atomic<int64_t> m_value{0};
+            std::mutex m_mutex;
+            std::vector<void *> m_waiters; // parked fibers
+        };
+
+        struct FiberJobSystemConfig
+        {
+            size_t workerThreads = std::thread::hardware_concurrency();
+            // Usable stack per fiber; a guard page below it catches overflow
+            size_t stackSize = 64 * 1024;
+            // Fibers created up front. More are created whenever every pooled
+            // fiber is parked, so waits can never deadlock on fiber exhaustion.
+            size_t initialFibers = 32;
+        };
+
+        // Job system whose jobs run on user-mode fibers (ucontext on POSIX,
+        // Win32 fibers on Windows). Like ThreadPool, each worker owns a
+        // Chase-Lev deque and steals when it runs dry. The difference is
+        // waitFor(): on a job fiber it switches to another job instead of
+        // blocking or nesting the wait on the same stack. A parked fiber can be
+        // resumed by any worker, so jobs must not hold thread_local state or
+        // locks across a wait.
+        class FiberJobSystem
+        {
+        public:
+            explicit FiberJobSystem(const FiberJobSystemConfig &config = {});
+            ~FiberJobSystem();
+            FiberJobSystem(const FiberJobSystem &) = delete;
+            FiberJobSystem &operator=(const FiberJobSystem &) = delete;
+
+            // counter, if given, is incremented now and decremented once the job has run
+            template <typename F>
+            void run(F &&f, JobCounter *counter = nullptr)
+            {
+                submit(makeTask(std::forward<F>(f)), counter);
+            }
+
+            void submit(InlineTask job, JobCounter *counter);
+
+            // Returns once counter reaches zero. Jobs park their fiber and the
+            // worker moves on to other jobs. Any other thread yields until the
+            // counter is done: jobs it ran would fork their children into the
+            // shared FIFO queue, turning depth-first recursion breadth-first and
+            // parking a fiber per node.
+            void waitFor(JobCounter &counter);
+
+            size_t size() const { return m_workers.size(); }
+            size_t fiberCount() const { return m_fibersCreated.load(std::memory_order_relaxed); }
+
+        private:
+            struct Job
+            {
+                InlineTask function;
+                JobCounter *counter = nullptr;
+            };
+            struct Fiber;
+            struct Worker;
+
+            static void fiberMain(Fiber *self);
+
+            Job *allocateJob();
+            void releaseJob(Job *job);
+            Fiber *acquireFiber();
+            Fiber *createFiber();
+            void destroyFiber(Fiber *fiber);
+            void releaseFiber(Fiber *fiber);
+            void parkFiber(Fiber *fiber, JobCounter &counter);
+            void makeReady(Fiber *fiber);
+
+            Job *findJob(Worker *self);
+            bool hasVisibleWork() const;
+            bool runOne(Worker *self);
+            void execute(Job *job);
+            void workerLoop(Worker *self);
+
+            FiberJobSystemConfig m_config;
+            std::vector<std::unique_ptr<Worker>> m_workers;
+            MpmcQueue<Job *> m_injection;
+            std::mutex m_overflowMutex;
+            std::deque<Job *> m_overflow;
+            std::atomic<size_t> m_overflowSize{0};
+
+            // Fibers whose counter reached zero, waiting for a worker to resume them
+            std::mutex m_readyMutex;
+            std::deque<Fiber *> m_ready;
+            std::atomic<size_t> m_readySize{0};
+
+            MpmcQueue<Job *> m_freeJobs;
+            MpmcQueue<Fiber *> m_freeFibers;
+            std::mutex m_fibersMutex;
+            std::vector<Fiber *> m_fibers;
+            std::atomic<size_t> m_fibersCreated{0};
+
+            EventCount m_idle;
+            std::atomic<bool> m_stopping{false};
+        };
+    }
+}
@@ -0,0 +1,476 @@
+#pragma once
+
+#include "xeno-pal-workqueue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace xeno
+{
+    namespace pal
+    {
+        // Values match the XENO_LOG_LEVEL_* macros below
+        enum class LogLevel : uint8_t
+        {
+            Trace,
+            Debug,
+            Info,
+            Warning,
+            Error
+        };
+
+        // Runtime filter shared by a group of log statements, e.g.
+        //
+        //     inline xeno::pal::LogCategory renderLog{"Render"};
+        //
+        // Checking it costs one relaxed load, so a disabled statement skips
+        // its arguments for the price of a compare.
+        class LogCategory
+        {
+        public:
+            constexpr explicit LogCategory(const char *name, LogLevel minimum = LogLevel::Info)
+                : m_name(name), m_minimum(static_cast<uint8_t>(minimum))
+            {
+            }
+            LogCategory(const LogCategory &) = delete;
+            LogCategory &operator=(const LogCategory &) = delete;
+
+            bool enabled(LogLevel level) const
+            {
+                return static_cast<uint8_t>(level) >= m_minimum.load(std::memory_order_relaxed);
+            }
+
+            // Takes effect on other threads at their next check
+            void setMinimumLevel(LogLevel level) { m_minimum.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+            LogLevel minimumLevel() const { return static_cast<LogLevel>(m_minimum.load(std::memory_order_relaxed)); }
+            const char *name() const { return m_name; }
+
+        private:
+            const char *m_name;
+            std::atomic<uint8_t> m_minimum;
+        };
+
+        // One per log statement, in static storage (XENO_LOG creates it).
+        // Structured records point at their site instead of carrying the
+        // format string, so a call only copies its raw arguments.
+        struct LogSite
+        {
+            const char *format; // each "{}" is replaced by the next argument
+            LogLevel level;
+            const char *file;
+            int line;
+        };
+
+        // What log() does when the ring is full
+        enum class LogOverflow
+        {
+            Drop,         // discard the record
+            Block,        // wait for the writer thread to make room
+            CountDropped  // discard, and have the writer note how many were lost
+        };
+
+        // What the writer thread puts in the file
+        enum class LogEncoding
+        {
+            Text,  // formatted lines, structured records formatted by the writer
+            Binary // binarylog entries; read back with xeno_log_decode
+        };
+
+        // Where the writer thread puts its output
+        enum class LogSink
+        {
+            File,  // buffered appends through stdio
+            Mapped // copies into a pre-sized, memory-mapped file; see MappedLogHeader
+        };
+
+        // A LogSink::Mapped file starts with this header, followed by
+        // capacity bytes of log. The writer copies entries in and only then
+        // advances committed, so if the process dies everything up to
+        // committed is complete and the rest of the file is zeros. After a
+        // power cut that only holds for what was written before the last
+        // flush(). A cleanly closed file is cut down to the committed bytes.
+        struct MappedLogHeader
+        {
+            static constexpr char Magic[8] = {'X', 'E', 'N', 'O', 'S', 'E', 'G', '1'};
+
+            char magic[8];
+            uint64_t committed; // bytes of log after the header
+            uint64_t capacity;  // bytes of log the file was sized for
+            char reserved[40];
+        };
+        static_assert(sizeof(MappedLogHeader) == 64);
+
+        struct LoggerConfig
+        {
+            size_t capacity = 1024; // records per logging thread; must be a power of two
+            LogOverflow overflow = LogOverflow::CountDropped;
+            LogEncoding encoding = LogEncoding::Text;
+            LogSink sink = LogSink::File;
+
+            // Once the file would grow past rotateBytes it is renamed to
+            // <name>.1, older ones shift up to <name>.<keepFiles>, and a new
+            // file is started. 0 never rotates a File sink and gives a Mapped
+            // sink 64 MiB files. Otherwise at least 64 KiB; for Mapped it is
+            // the size of every file, header included.
+            size_t rotateBytes = 0;
+            uint32_t keepFiles = 4;
+        };
+
+        // Binary log layout. The file starts with Magic, followed by entries
+        // that each begin with an EntryType byte. Integers are little-endian.
+        //
+        //   Format: u32 id, u8 level, u32 line, u16 size + file, u16 size + format
+        //   Record: u32 id, u64 wall-clock ns, u16 size + packed arguments
+        //
+        // A Format entry comes before the first Record that uses its id. Ids
+        // restart when a writer reopens the file, and a later Format entry for
+        // the same id replaces the earlier one.
+        namespace binarylog
+        {
+            inline constexpr char Magic[8] = {'X', 'E', 'N', 'O', 'L', 'O', 'G', '1'};
+
+            enum class EntryType : uint8_t
+            {
+                Format = 1,
+                Record = 2
+            };
+
+            // Each packed argument is an ArgType byte followed by its value:
+            // 8 bytes for numbers, u16 size + bytes for strings
+            enum class ArgType : uint8_t
+            {
+                Int = 1,
+                UInt = 2,
+                Double = 3,
+                String = 4
+            };
+
+            inline bool packBytes(char *out, size_t capacity, size_t &used, ArgType type, const void *value, size_t size)
+            {
+                if (used + 1 + size > capacity)
+                {
+                    return false;
+                }
+                out[used] = static_cast<char>(type);
+                std::memcpy(out + used + 1, value, size);
+                used += 1 + size;
+                return true;
+            }
+
+            inline bool packString(char *out, size_t capacity, size_t &used, std::string_view value)
+            {
+                if (used + 3 > capacity)
+                {
+                    return false;
+                }
+                // Strings are cut to whatever room is left
+                uint16_t size = static_cast<uint16_t>(std::min(value.size(), capacity - used - 3));
+                out[used] = static_cast<char>(ArgType::String);
+                std::memcpy(out + used + 1, &size, sizeof(size));
+                std::memcpy(out + used + 3, value.data(), size);
+                used += 3 + size;
+                return true;
+            }
+
+            // Appends one argument to a packed payload. Returns false once it
+            // no longer fits, which drops that argument and the rest.
+            template <typename T>
+            bool pack(char *out, size_t capacity, size_t &used, const T &value)
+            {
+                using U = std::decay_t<T>;
+                if constexpr (std::is_same_v<U, bool>)
+                {
+                    uint64_t number = value ? 1 : 0;
+                    return packBytes(out, capacity, used, ArgType::UInt, &number, sizeof(number));
+                }
+                else if constexpr (std::is_enum_v<U>)
+                {
+                    int64_t number = static_cast<int64_t>(value);
+                    return packBytes(out, capacity, used, ArgType::Int, &number, sizeof(number));
+                }
+                else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+                {
+                    int64_t number = value;
+                    return packBytes(out, capacity, used, ArgType::Int, &number, sizeof(number));
+                }
+                else if constexpr (std::is_integral_v<U>)
+                {
+                    uint64_t number = value;
+                    return packBytes(out, capacity, used, ArgType::UInt, &number, sizeof(number));
+                }
+                else if constexpr (std::is_floating_point_v<U>)
+                {
+                    double number = value;
+                    return packBytes(out, capacity, used, ArgType::Double, &number, sizeof(number));
+                }
+                else
+                {
+                    static_assert(std::is_convertible_v<const U &, std::string_view>,
+                                  "log arguments must be numbers, enums, bools or strings");
+                    return packString(out, capacity, used, std::string_view(value));
+                }
+            }
+
+            // Appends format to out with each "{}" replaced by the next packed
+            // argument. Placeholders without an argument are kept as-is.
+            void formatPacked(std::string &out, std::string_view format, const char *args, size_t size);
+
+            // Turns a binary log back into the lines a Text logger would have
+            // written. A LogSink::Mapped file is unwrapped first, and passed
+            // through unchanged if it holds text. Throws std::runtime_error on
+            // a malformed file.
+            void decode(std::istream &in, std::ostream &out);
+        }
+
+        // Monotonic tick count that orders log records across threads: the
+        // invariant TSC on x86 (fenced so it cannot run ahead of earlier
+        // instructions), steady_clock nanoseconds elsewhere
+        inline uint64_t logTicks()
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_lfence();
+            return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+            _mm_lfence();
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+#endif
+        }
+
+        // logTicks() per second, measured once per process
+        uint64_t logTicksPerSecond();
+
+        // Per-site budget behind XENO_LOG_LIMITED, in static storage next to
+        // the site. Lets up to perSecond records through in each one-second
+        // window and counts the rest. Once a site is over budget a call costs
+        // a tick read, a load and one relaxed increment.
+        class LogLimiter
+        {
+        public:
+            constexpr LogLimiter() = default;
+            LogLimiter(const LogLimiter &) = delete;
+            LogLimiter &operator=(const LogLimiter &) = delete;
+
+            // True if the record may be logged; suppressed is then the number
+            // held back since the site last got through. Concurrent callers
+            // can push a window a record or two past its budget.
+            bool allow(uint32_t perSecond, uint64_t &suppressed)
+            {
+                uint64_t now = logTicks();
+                uint64_t start = m_windowStart.load(std::memory_order_relaxed);
+                if (now - start >= logTicksPerSecond() &&
+                    m_windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+                {
+                    m_passed.store(0, std::memory_order_relaxed);
+                }
+                if (m_passed.load(std::memory_order_relaxed) >= perSecond ||
+                    m_passed.fetch_add(1, std::memory_order_relaxed) >= perSecond)
+                {
+                    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                suppressed = m_suppressed.load(std::memory_order_relaxed) == 0
+                                 ? 0
+                                 : m_suppressed.exchange(0, std::memory_order_relaxed);
+                return true;
+            }
+
+        private:
+            std::atomic<uint64_t> m_windowStart{0};
+            std::atomic<uint32_t> m_passed{0};
+            std::atomic<uint64_t> m_suppressed{0};
+        };
+
+        // Callers format a fixed-size record into their own thread's ring and
+        // return, so logging threads share no lock or cache line. A background
+        // thread merges the rings in timestamp order and batches the result
+        // to the file. Messages longer than MaxMessageLength are truncated, as
+        // are structured records whose packed arguments do not fit.
+        class Logger
+        {
+        public:
+            using LogLevel = pal::LogLevel;
+
+            static constexpr size_t MaxMessageLength = 224;
+
+            Logger(const std::string &filename, const LoggerConfig &config = {});
+            ~Logger();
+            Logger(const Logger &) = delete;
+            Logger &operator=(const Logger &) = delete;
+
+            void log(std::string_view message, LogLevel level = LogLevel::Info);
+
+            // Structured record: copies args raw and leaves formatting to the
+            // writer thread (Text) or to the decoder (Binary). Use XENO_LOG.
+            template <typename... Args>
+            void log(const LogSite &site, const Args &...args)
+            {
+                Record record;
+                record.kind = RecordKind::Structured;
+                record.level = site.level;
+                record.site = &site;
+                size_t used = 0;
+                (void)(binarylog::pack(record.text, MaxMessageLength, used, args) && ...);
+                record.length = static_cast<uint16_t>(used);
+                submit(record);
+            }
+
+            // Returns once everything logged before the call, by any thread,
+            // is written and synced to disk
+            void flush();
+            void logInfo(std::string_view message);
+            void logWarning(std::string_view message);
+            void logError(std::string_view message);
+
+            // Records discarded under LogOverflow::CountDropped
+            uint64_t droppedCount() const { return m_droppedTotal.load(std::memory_order_relaxed); }
+
+        private:
+            enum class RecordKind : uint8_t
+            {
+                Message,
+                Structured,
+                Flush
+            };
+
+            struct Record
+            {
+                uint64_t ticks = 0;  // logTicks() when the record was pushed
+                uint64_t ticket = 0; // flush request being answered
+                const LogSite *site = nullptr;
+                LogLevel level = LogLevel::Info;
+                RecordKind kind = RecordKind::Message;
+                uint16_t length = 0;
+                char text[MaxMessageLength]; // 256-byte records
+            };
+
+            struct ThreadBuffer;
+            class Sink;
+
+            ThreadBuffer &threadBuffer();
+            void submit(Record &record);
+            void pushBlocking(ThreadBuffer &buffer, Record &record);
+            void writerLoop();
+
+            std::unique_ptr<Sink> m_sink;
+            LogOverflow m_overflow;
+            LogEncoding m_encoding;
+            size_t m_capacity;
+            uint64_t m_id; // tells this logger's thread buffers apart from others'
+
+            // Every thread that has logged here, registered on its first record
+            std::mutex m_buffersMutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+            std::atomic<uint64_t> m_buffersVersion{0};
+
+            // Pairs a tick count with both clocks, so the writer can turn
+            // record ticks back into wall-clock time
+            uint64_t m_baseTicks = 0;
+            uint64_t m_baseSteadyNs = 0;
+            uint64_t m_baseWallNs = 0;
+
+            EventCount m_wake;
+            std::atomic<bool> m_stopping{false};
+            std::atomic<uint64_t> m_dropped{0}; // since the writer last reported
+            std::atomic<uint64_t> m_droppedTotal{0};
+
+            std::mutex m_flushMutex;
+            std::condition_variable m_flushed;
+            uint64_t m_flushRequested = 0;
+            uint64_t m_flushCompleted = 0;
+
+            std::thread m_writer;
+        };
+    }
+}
+
+#define XENO_LOG_LEVEL_TRACE 0
+#define XENO_LOG_LEVEL_DEBUG 1
+#define XENO_LOG_LEVEL_INFO 2
+#define XENO_LOG_LEVEL_WARNING 3
+#define XENO_LOG_LEVEL_ERROR 4
+
+// Statements below this level are compiled out, arguments included. Defaults
+// to everything in debug builds and Info and up in release builds.
+#ifndef XENO_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define XENO_LOG_MIN_LEVEL XENO_LOG_LEVEL_INFO
+#else
+#define XENO_LOG_MIN_LEVEL XENO_LOG_LEVEL_TRACE
+#endif
+#endif
+
+// XENO_LOG(logger, category, level, "loaded {} meshes in {} ms", count, ms)
+// records a static site plus the raw arguments; nothing is formatted on the
+// caller. The arguments are only evaluated when level passes both the
+// compile-time minimum and the category's runtime filter. Compiled-out
+// statements are still type-checked.
+#define XENO_LOG(logger, category, level, format, ...)                                                 \
+    do                                                                                                 \
+    {                                                                                                  \
+        if constexpr (static_cast<int>(level) >= XENO_LOG_MIN_LEVEL)                                   \
+        {                                                                                              \
+            if ((category).enabled(level))                                                             \
+            {                                                                                          \
+                static constexpr ::xeno::pal::LogSite xenoLogSite{format, level, __FILE__, __LINE__};  \
+                (logger).log(xenoLogSite __VA_OPT__(, ) __VA_ARGS__);                                  \
+            }                                                                                          \
+        }                                                                                              \
+    } while (0)
+
+// XENO_LOG for statements that can fire every frame or every item, such as
+// a failing resource inside a loop. Past perSecond records a second the site
+// is skipped, arguments included. Its next record to get through is preceded
+// by "last message repeated N times: <format>".
+#define XENO_LOG_LIMITED(logger, category, level, perSecond, format, ...)                                   \
+    do                                                                                                      \
+    {                                                                                                       \
+        if constexpr (static_cast<int>(level) >= XENO_LOG_MIN_LEVEL)                                        \
+        {                                                                                                   \
+            if ((category).enabled(level))                                                                  \
+            {                                                                                               \
+                static constexpr ::xeno::pal::LogSite xenoLogSite{format, level, __FILE__, __LINE__};       \
+                static constexpr ::xeno::pal::LogSite xenoRepeatSite{"last message repeated {} times: {}",  \
+                                                                     level, __FILE__, __LINE__};            \
+                static ::xeno::pal::LogLimiter xenoLogLimiter;                                              \
+                uint64_t xenoSuppressed = 0;                                                                \
+                if (xenoLogLimiter.allow(perSecond, xenoSuppressed))                                        \
+                {                                                                                           \
+                    if (xenoSuppressed > 0)                                                                 \
+                    {                                                                                       \
+                        (logger).log(xenoRepeatSite, xenoSuppressed, format);                               \
+                    }                                                                                       \
+                    (logger).log(xenoLogSite __VA_OPT__(, ) __VA_ARGS__);                                   \
+                }                                                                                           \
+            }                                                                                               \
+        }                                                                                                   \
+    } while (0)
+
+#define XENO_LOG_TRACE(logger, category, ...) XENO_LOG(logger, category, ::xeno::pal::LogLevel::Trace, __VA_ARGS__)
+#define XENO_LOG_DEBUG(logger, category, ...) XENO_LOG(logger, category, ::xeno::pal::LogLevel::Debug, __VA_ARGS__)
+#define XENO_LOG_INFO(logger, category, ...) XENO_LOG(logger, category, ::xeno::pal::LogLevel::Info, __VA_ARGS__)
+#define XENO_LOG_WARNING(logger, category, ...) XENO_LOG(logger, category, ::xeno::pal::LogLevel::Warning, __VA_ARGS__)
+#define XENO_LOG_ERROR(logger, category, ...) XENO_LOG(logger, category, ::xeno::pal::LogLevel::Error, __VA_ARGS__)
@@ -0,0 +1,237 @@
+#include "xeno-pal-memory.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace xeno
+{
+    namespace pal
+    {
+        namespace memory
+        {
+            namespace
+            {
+                constexpr size_t TagCount = static_cast<size_t>(MemoryTag::Count);
+
+                struct Counters
+                {
+                    std::atomic<int64_t> bytes[TagCount] = {};
+                    std::atomic<uint64_t> allocations[TagCount] = {};
+                };
+
+                struct TagState
+                {
+                    std::atomic<int64_t> peak{0};
+                    std::atomic<size_t> budget{0};
+                    std::atomic<bool> overBudget{false}; // as of the last sample()
+                };
+
+                struct Registry
+                {
+                    std::mutex mutex;
+                    std::vector<Counters *> threads;
+                    Counters retired;
+                    TagState tags[TagCount];
+                };
+
+                Registry &registry()
+                {
+                    // Leaked on purpose: threads may still record during static destruction
+                    static Registry *instance = new Registry();
+                    return *instance;
+                }
+
+                // Trivially destructible, so it can still be read after the
+                // thread's ThreadCounters is gone
+                thread_local bool t_countersRetired = false;
+
+                struct ThreadCounters
+                {
+                    Counters counters;
+
+                    ThreadCounters()
+                    {
+                        Registry &reg = registry();
+                        std::lock_guard<std::mutex> lock(reg.mutex);
+                        reg.threads.push_back(&counters);
+                    }
+
+                    ~ThreadCounters()
+                    {
+                        Registry &reg = registry();
+                        std::lock_guard<std::mutex> lock(reg.mutex);
+                        for (size_t i = 0; i < TagCount; ++i)
+                        {
+                            reg.retired.bytes[i].fetch_add(counters.bytes[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                            reg.retired.allocations[i].fetch_add(counters.allocations[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                        }
+                        reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), &counters));
+                        t_countersRetired = true;
+                    }
+                };
+
+                Counters &localCounters()
+                {
+                    thread_local ThreadCounters counters;
+                    return counters.counters;
+                }
+
+                // Thread-local destructors run in reverse order of construction,
+                // and allocators such as scratch() can be built before this
+                // thread's counters. Whatever they free afterwards goes straight
+                // to the retired totals.
+                void recordRetired(size_t index, int64_t bytes, uint64_t allocations)
+                {
+                    Registry &reg = registry();
+                    reg.retired.bytes[index].fetch_add(bytes, std::memory_order_relaxed);
+                    reg.retired.allocations[index].fetch_add(allocations, std::memory_order_relaxed);
+                }
+
+                // Only the owning thread writes its counters, so a relaxed
+                // load/store pair is enough and avoids a locked RMW.
+                template <typename T>
+                void bump(std::atomic<T> &counter, T delta)
+                {
+                    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+                }
+
+                // Caller holds the registry mutex
+                void total(Registry &reg, size_t index, int64_t &bytes, uint64_t &allocations)
+                {
+                    bytes = reg.retired.bytes[index].load(std::memory_order_relaxed);
+                    allocations = reg.retired.allocations[index].load(std::memory_order_relaxed);
+                    for (Counters *counters : reg.threads)
+                    {
+                        bytes += counters->bytes[index].load(std::memory_order_relaxed);
+                        allocations += counters->allocations[index].load(std::memory_order_relaxed);
+                    }
+                }
+
+                void updatePeak(TagState &state, int64_t bytes)
+                {
+                    int64_t peak = state.peak.load(std::memory_order_relaxed);
+                    while (bytes > peak && !state.peak.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+                    {
+                    }
+                }
+
+                bool isOverBudget(const TagState &state, int64_t bytes)
+                {
+                    size_t budget = state.budget.load(std::memory_order_relaxed);
+                    return budget > 0 && bytes > static_cast<int64_t>(budget);
+                }
+
+                MemoryTagStats collect(Registry &reg, size_t index)
+                {
+                    MemoryTagStats result;
+                    result.tag = static_cast<MemoryTag>(index);
+                    result.name = tagName(result.tag);
+                    total(reg, index, result.currentBytes, result.allocations);
+                    updatePeak(reg.tags[index], result.currentBytes);
+                    result.sampledPeakBytes = reg.tags[index].peak.load(std::memory_order_relaxed);
+                    result.budgetBytes = reg.tags[index].budget.load(std::memory_order_relaxed);
+                    result.overBudget = isOverBudget(reg.tags[index], result.currentBytes);
+                    return result;
+                }
+            }
+
+            void recordAllocation(MemoryTag tag, size_t bytes)
+            {
+                size_t index = static_cast<size_t>(tag);
+                if (t_countersRetired)
+                {
+                    recordRetired(index, static_cast<int64_t>(bytes), 1);
+                    return;
+                }
+                Counters &counters = localCounters();
+                bump<int64_t>(counters.bytes[index], static_cast<int64_t>(bytes));
+                bump<uint64_t>(counters.allocations[index], 1);
+            }
+
+            void recordFree(MemoryTag tag, size_t bytes)
+            {
+                if (t_countersRetired)
+                {
+                    recordRetired(static_cast<size_t>(tag), -static_cast<int64_t>(bytes), 0);
+                    return;
+                }
+                Counters &counters = localCounters();
+                bump<int64_t>(counters.bytes[static_cast<size_t>(tag)], -static_cast<int64_t>(bytes));
+            }
+
+            void setBudget(MemoryTag tag, size_t bytes)
+            {
+                registry().tags[static_cast<size_t>(tag)].budget.store(bytes, std::memory_order_relaxed);
+            }
+
+            const char *tagName(MemoryTag tag)
+            {
+                switch (tag)
+                {
+                case MemoryTag::General:
+                    return "General";
+                case MemoryTag::Frame:
+                    return "Frame";
+                case MemoryTag::Scratch:
+                    return "Scratch";
+                case MemoryTag::Terrain:
+                    return "Terrain";
+                case MemoryTag::Renderer:
+                    return "Renderer";
+                case MemoryTag::Logger:
+                    return "Logger";
+                case MemoryTag::IO:
+                    return "IO";
+                case MemoryTag::Tasks:
+                    return "Tasks";
+                default:
+                    return "Unknown";
+                }
+            }
+
+            MemoryTagStats stats(MemoryTag tag)
+            {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                return collect(reg, static_cast<size_t>(tag));
+            }
+
+            std::vector<MemoryTagStats> report()
+            {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                std::vector<MemoryTagStats> result;
+                result.reserve(TagCount);
+                for (size_t i = 0; i < TagCount; ++i)
+                {
+                    result.push_back(collect(reg, i));
+                }
+                return result;
+            }
+
+            uint32_t sample()
+            {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                uint32_t exceeded = 0;
+                for (size_t i = 0; i < TagCount; ++i)
+                {
+                    int64_t bytes;
+                    uint64_t allocations;
+                    total(reg, i, bytes, allocations);
+                    updatePeak(reg.tags[i], bytes);
+                    bool over = isOverBudget(reg.tags[i], bytes);
+                    if (over && !reg.tags[i].overBudget.exchange(true, std::memory_order_relaxed))
+                    {
+                        exceeded |= 1u << i;
+                    }
+                    else if (!over)
+                    {
+                        reg.tags[i].overBudget.store(false, std::memory_order_relaxed);
+                    }
+                }
+                return exceeded;
+            }
+        }
+    }
+}
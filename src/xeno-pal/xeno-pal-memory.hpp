@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xeno
+{
+    namespace pal
+    {
+        enum class MemoryTag : uint8_t
+        {
+            General,
+            Frame,
+            Scratch,
+            Terrain,
+            Renderer,
+            Logger,
+            IO,
+            Tasks,
+            Count
+        };
+
+        struct MemoryTagStats
+        {
+            MemoryTag tag;
+            const char *name;
+            int64_t currentBytes;
+            int64_t sampledPeakBytes; // largest total seen by sample() or a query
+            uint64_t allocations;
+            size_t budgetBytes; // 0 means no budget
+            bool overBudget;
+        };
+
+        // Tagged memory accounting. Each thread records into its own counters
+        // with relaxed stores, so recording never contends; queries sum the
+        // counters of every live thread plus those folded in by exited threads.
+        // There is no shared total to track a true peak against, so peaks
+        // are sampled: a spike that comes and goes between two sample() calls
+        // is not seen.
+        namespace memory
+        {
+            void recordAllocation(MemoryTag tag, size_t bytes);
+            void recordFree(MemoryTag tag, size_t bytes);
+
+            void setBudget(MemoryTag tag, size_t bytes);
+            const char *tagName(MemoryTag tag);
+
+            MemoryTagStats stats(MemoryTag tag);
+            std::vector<MemoryTagStats> report();
+
+            // Refreshes peaks and budget state without allocating. Returns a
+            // bitmask (1 << tag) of tags that went over budget since the last
+            // call.
+            uint32_t sample();
+        }
+    }
+}
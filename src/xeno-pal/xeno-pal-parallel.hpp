@@ -0,0 +1,152 @@
+#pragma once
+
+#include "xeno-pal.hpp"
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace xeno
+{
+    namespace pal
+    {
+        // Data-parallel loops on top of ThreadPool. Ranges are split in halves:
+        // the right half is forked onto the pool and the left half keeps
+        // splitting on the calling thread, so idle workers steal the largest
+        // remaining pieces first. With grain == 0 the leaf size adapts to the
+        // range and the worker count (roughly eight leaves per worker).
+
+        namespace detail
+        {
+            inline size_t adaptiveGrain(const ThreadPool &pool, size_t count, size_t grain)
+            {
+                if (grain > 0)
+                {
+                    return grain;
+                }
+                size_t leaves = (pool.size() + 1) * 8;
+                size_t adaptive = count / leaves;
+                return adaptive > 0 ? adaptive : 1;
+            }
+
+            template <typename Body>
+            void forRange(ThreadPool &pool, size_t begin, size_t end, size_t grain, const Body &body)
+            {
+                TaskGroup group(pool);
+                while (end - begin > grain)
+                {
+                    size_t middle = begin + (end - begin) / 2;
+                    group.run([&pool, middle, end, grain, &body]()
+                              { forRange(pool, middle, end, grain, body); });
+                    end = middle;
+                }
+                body(begin, end);
+                group.wait();
+            }
+
+            template <typename T, typename Map, typename Combine>
+            T reduceRange(ThreadPool &pool, size_t begin, size_t end, size_t grain, const Map &map, const Combine &combine)
+            {
+                if (end - begin <= grain)
+                {
+                    return map(begin, end);
+                }
+                size_t middle = begin + (end - begin) / 2;
+                T right{};
+                TaskGroup group(pool);
+                group.run([&]()
+                          { right = reduceRange<T>(pool, middle, end, grain, map, combine); });
+                T left = reduceRange<T>(pool, begin, middle, grain, map, combine);
+                group.wait();
+                return combine(left, right);
+            }
+        }
+
+        // body(first, last) is called on disjoint subranges covering [begin, end)
+        template <typename Body>
+        void parallelFor(ThreadPool &pool, size_t begin, size_t end, const Body &body, size_t grain = 0)
+        {
+            if (end <= begin)
+            {
+                return;
+            }
+            detail::forRange(pool, begin, end, detail::adaptiveGrain(pool, end - begin, grain), body);
+        }
+
+        // map(first, last) reduces a subrange to a T; combine(left, right) merges
+        // neighbouring results in order, so it need not be commutative.
+        template <typename T, typename Map, typename Combine>
+        T parallelReduce(ThreadPool &pool, size_t begin, size_t end, T identity, const Map &map, const Combine &combine,
+                         size_t grain = 0)
+        {
+            if (end <= begin)
+            {
+                return identity;
+            }
+            T result = detail::reduceRange<T>(pool, begin, end, detail::adaptiveGrain(pool, end - begin, grain), map, combine);
+            return combine(identity, result);
+        }
+
+        // out[i] = init op in[0] op ... op in[i - 1]. Two passes over blocks:
+        // per-block totals in parallel, a serial scan of the totals, then each
+        // block is scanned in parallel from its offset. op must be associative.
+        // in and out may alias. Blocks are indexed directly, so both ranges
+        // must be random access.
+        template <typename RandomIt, typename RandomOutIt, typename T, typename Op>
+        void parallelExclusiveScan(ThreadPool &pool, RandomIt first, RandomIt last, RandomOutIt out, T init, const Op &op,
+                                   size_t grain = 0)
+        {
+            static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                                            typename std::iterator_traits<RandomIt>::iterator_category>,
+                          "parallelExclusiveScan needs random access input");
+            static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                                            typename std::iterator_traits<RandomOutIt>::iterator_category>,
+                          "parallelExclusiveScan needs random access output");
+            size_t count = static_cast<size_t>(std::distance(first, last));
+            if (count == 0)
+            {
+                return;
+            }
+            size_t blockSize = detail::adaptiveGrain(pool, count, grain);
+            size_t blockCount = (count + blockSize - 1) / blockSize;
+
+            std::vector<T> offsets(blockCount);
+            parallelFor(pool, 0, blockCount, [&](size_t firstBlock, size_t lastBlock)
+                        {
+                for (size_t block = firstBlock; block < lastBlock; ++block)
+                {
+                    size_t begin = block * blockSize;
+                    size_t end = begin + blockSize < count ? begin + blockSize : count;
+                    T total = first[begin];
+                    for (size_t i = begin + 1; i < end; ++i)
+                    {
+                        total = op(total, first[i]);
+                    }
+                    offsets[block] = total;
+                } }, 1);
+
+            T running = init;
+            for (size_t block = 0; block < blockCount; ++block)
+            {
+                T total = offsets[block];
+                offsets[block] = running;
+                running = op(running, total);
+            }
+
+            parallelFor(pool, 0, blockCount, [&](size_t firstBlock, size_t lastBlock)
+                        {
+                for (size_t block = firstBlock; block < lastBlock; ++block)
+                {
+                    size_t begin = block * blockSize;
+                    size_t end = begin + blockSize < count ? begin + blockSize : count;
+                    T sum = offsets[block];
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        T value = first[i];
+                        out[i] = sum;
+                        sum = op(sum, value);
+                    }
+                } }, 1);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#include "xeno-pal-pmr.hpp"
+#include <new>
+
+namespace xeno
+{
+    namespace pal
+    {
+        void *ArenaResource::do_allocate(size_t bytes, size_t alignment)
+        {
+            return m_arena.allocate(bytes, alignment);
+        }
+
+        void ArenaResource::do_deallocate(void *, size_t, size_t)
+        {
+        }
+
+        bool ArenaResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+        {
+            const ArenaResource *resource = dynamic_cast<const ArenaResource *>(&other);
+            return resource && &resource->m_arena == &m_arena;
+        }
+
+        void *PoolResource::do_allocate(size_t bytes, size_t alignment)
+        {
+            // The pool's own oversized path is plain ::operator new, which only
+            // guarantees the default new alignment
+            if (bytes > SizeClassPool::MaxBlockSize || alignment > BlockPool::CacheLineSize)
+            {
+                memory::recordAllocation(m_pool.tag(), bytes);
+                return ::operator new(bytes, std::align_val_t(alignment));
+            }
+            // A power-of-two class of at least `alignment` bytes is aligned to it
+            return m_pool.allocate(bytes < alignment ? alignment : bytes);
+        }
+
+        void PoolResource::do_deallocate(void *ptr, size_t bytes, size_t alignment)
+        {
+            if (bytes > SizeClassPool::MaxBlockSize || alignment > BlockPool::CacheLineSize)
+            {
+                memory::recordFree(m_pool.tag(), bytes);
+                ::operator delete(ptr, std::align_val_t(alignment));
+                return;
+            }
+            m_pool.deallocate(ptr, bytes < alignment ? alignment : bytes);
+        }
+
+        bool PoolResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+        {
+            const PoolResource *resource = dynamic_cast<const PoolResource *>(&other);
+            return resource && &resource->m_pool == &m_pool;
+        }
+    }
+}
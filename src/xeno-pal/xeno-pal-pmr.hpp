@@ -0,0 +1,49 @@
+#pragma once
+
+#include "xeno-pal.hpp"
+#include "xeno-pal-pool.hpp"
+#include <memory_resource>
+
+namespace xeno
+{
+    namespace pal
+    {
+        // std::pmr view of an Arena. deallocate() is a no-op; memory comes back
+        // when the arena is reset or rewound, so containers using this resource
+        // must not outlive the arena's current frame or scope. Usage is
+        // accounted under the arena's MemoryTag.
+        class ArenaResource : public std::pmr::memory_resource
+        {
+        public:
+            explicit ArenaResource(Arena &arena) : m_arena(arena) {}
+
+            Arena &arena() const { return m_arena; }
+
+        private:
+            void *do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void *ptr, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+            Arena &m_arena;
+        };
+
+        // std::pmr view of a SizeClassPool. Requests larger than the biggest
+        // size class, or aligned beyond a cache line, go to the aligned
+        // upstream heap. Smaller over-aligned requests stay in the pool:
+        // every class is a power of two and its blocks are aligned to it.
+        class PoolResource : public std::pmr::memory_resource
+        {
+        public:
+            explicit PoolResource(SizeClassPool &pool) : m_pool(pool) {}
+
+            SizeClassPool &pool() const { return m_pool; }
+
+        private:
+            void *do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void *ptr, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+            SizeClassPool &m_pool;
+        };
+    }
+}
@@ -0,0 +1,163 @@
+#include "xeno-pal-pool.hpp"
+#include <stdexcept>
+
+namespace xeno
+{
+    namespace pal
+    {
+        namespace
+        {
+            size_t roundUp(size_t value, size_t multiple)
+            {
+                return ((value + multiple - 1) / multiple) * multiple;
+            }
+        }
+
+        BlockPool::BlockPool(size_t blockSize, size_t alignment, size_t blocksPerSlab, MemoryTag tag)
+            : m_tag(tag)
+        {
+            if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+            {
+                throw std::runtime_error("BlockPool alignment must be a power of two");
+            }
+            if (alignment < alignof(FreeBlock))
+            {
+                alignment = alignof(FreeBlock);
+            }
+
+            // Every block has to be able to hold the free-list link
+            m_blockSize = roundUp(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize, alignment);
+            m_slabAlignment = alignment > CacheLineSize ? alignment : CacheLineSize;
+            m_blocksPerSlab = blocksPerSlab > 0 ? blocksPerSlab : DefaultSlabSize / m_blockSize;
+            if (m_blocksPerSlab == 0)
+            {
+                m_blocksPerSlab = 1;
+            }
+        }
+
+        BlockPool::~BlockPool()
+        {
+            memory::recordFree(m_tag, m_slabs.size() * m_blockSize * m_blocksPerSlab);
+            for (void *slab : m_slabs)
+            {
+                ::operator delete(slab, std::align_val_t(m_slabAlignment));
+            }
+        }
+
+        void *BlockPool::allocate()
+        {
+            if (!m_freeList)
+            {
+                grow();
+            }
+            FreeBlock *block = m_freeList;
+            m_freeList = block->next;
+
+            ++m_totalAllocations;
+            if (++m_live > m_peakLive)
+            {
+                m_peakLive = m_live;
+            }
+            return block;
+        }
+
+        void BlockPool::deallocate(void *ptr)
+        {
+            if (!ptr)
+            {
+                return;
+            }
+            FreeBlock *block = static_cast<FreeBlock *>(ptr);
+            block->next = m_freeList;
+            m_freeList = block;
+            --m_live;
+        }
+
+        PoolStats BlockPool::stats() const
+        {
+            PoolStats stats;
+            stats.blockSize = m_blockSize;
+            stats.blocksPerSlab = m_blocksPerSlab;
+            stats.slabCount = m_slabs.size();
+            stats.capacity = m_slabs.size() * m_blocksPerSlab;
+            stats.live = m_live;
+            stats.peakLive = m_peakLive;
+            stats.totalAllocations = m_totalAllocations;
+            return stats;
+        }
+
+        void BlockPool::grow()
+        {
+            char *slab = static_cast<char *>(::operator new(m_blockSize * m_blocksPerSlab, std::align_val_t(m_slabAlignment)));
+            m_slabs.push_back(slab);
+            memory::recordAllocation(m_tag, m_blockSize * m_blocksPerSlab);
+
+            // Thread back to front so blocks are handed out in address order
+            for (size_t i = m_blocksPerSlab; i-- > 0;)
+            {
+                FreeBlock *block = reinterpret_cast<FreeBlock *>(slab + i * m_blockSize);
+                block->next = m_freeList;
+                m_freeList = block;
+            }
+        }
+
+        SizeClassPool::SizeClassPool(MemoryTag tag)
+            : m_tag(tag)
+        {
+            size_t blockSize = MinBlockSize;
+            for (size_t i = 0; i < ClassCount; ++i, blockSize <<= 1)
+            {
+                m_classes[i] = std::make_unique<BlockPool>(blockSize, alignof(std::max_align_t), 0, tag);
+            }
+        }
+
+        size_t SizeClassPool::classIndex(size_t size)
+        {
+            size_t index = 0;
+            size_t blockSize = MinBlockSize;
+            while (blockSize < size)
+            {
+                blockSize <<= 1;
+                ++index;
+            }
+            return index;
+        }
+
+        void *SizeClassPool::allocate(size_t size)
+        {
+            if (size > MaxBlockSize)
+            {
+                ++m_oversizedLive;
+                memory::recordAllocation(m_tag, size);
+                return ::operator new(size);
+            }
+            return m_classes[classIndex(size)]->allocate();
+        }
+
+        void SizeClassPool::deallocate(void *ptr, size_t size)
+        {
+            if (!ptr)
+            {
+                return;
+            }
+            if (size > MaxBlockSize)
+            {
+                --m_oversizedLive;
+                memory::recordFree(m_tag, size);
+                ::operator delete(ptr);
+                return;
+            }
+            m_classes[classIndex(size)]->deallocate(ptr);
+        }
+
+        std::array<PoolStats, SizeClassPool::ClassCount> SizeClassPool::stats() const
+        {
+            std::array<PoolStats, ClassCount> result;
+            for (size_t i = 0; i < ClassCount; ++i)
+            {
+                result[i] = m_classes[i]->stats();
+            }
+            return result;
+        }
+    }
+}
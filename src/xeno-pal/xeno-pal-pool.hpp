@@ -0,0 +1,137 @@
+#pragma once
+
+#include "xeno-pal-memory.hpp"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace xeno
+{
+    namespace pal
+    {
+        struct PoolStats
+        {
+            size_t blockSize = 0;
+            size_t blocksPerSlab = 0;
+            size_t slabCount = 0;
+            size_t capacity = 0;         // blocks across all slabs
+            size_t live = 0;             // blocks currently handed out
+            size_t peakLive = 0;         // most blocks ever live at once
+            size_t totalAllocations = 0; // allocate() calls since construction
+        };
+
+        // Fixed-size block allocator. Blocks are carved out of cache-line
+        // aligned slabs and recycled through an intrusive free list, so both
+        // allocate() and deallocate() are O(1). Not thread-safe.
+        class BlockPool
+        {
+        public:
+            static constexpr size_t CacheLineSize = 64;
+            static constexpr size_t DefaultSlabSize = 64 * 1024;
+
+            BlockPool(size_t blockSize, size_t alignment = alignof(std::max_align_t), size_t blocksPerSlab = 0,
+                      MemoryTag tag = MemoryTag::General);
+            ~BlockPool();
+            BlockPool(const BlockPool &) = delete;
+            BlockPool &operator=(const BlockPool &) = delete;
+
+            void *allocate();
+            void deallocate(void *ptr);
+
+            size_t blockSize() const { return m_blockSize; }
+            MemoryTag tag() const { return m_tag; }
+            PoolStats stats() const;
+
+        private:
+            struct FreeBlock
+            {
+                FreeBlock *next;
+            };
+
+            void grow();
+
+            size_t m_blockSize;
+            size_t m_slabAlignment;
+            size_t m_blocksPerSlab;
+            MemoryTag m_tag;
+            FreeBlock *m_freeList = nullptr;
+            std::vector<void *> m_slabs;
+            size_t m_live = 0;
+            size_t m_peakLive = 0;
+            size_t m_totalAllocations = 0;
+        };
+
+        // Typed front end over BlockPool. Objects still alive when the pool is
+        // destroyed have their storage released without running destructors.
+        template <class T>
+        class Pool
+        {
+        public:
+            explicit Pool(size_t objectsPerSlab = 0, MemoryTag tag = MemoryTag::General)
+                : m_blocks(sizeof(T), alignof(T), objectsPerSlab, tag)
+            {
+            }
+
+            template <class... Args>
+            T *create(Args &&...args)
+            {
+                void *memory = m_blocks.allocate();
+                try
+                {
+                    return new (memory) T(std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    m_blocks.deallocate(memory);
+                    throw;
+                }
+            }
+
+            void destroy(T *object)
+            {
+                if (object)
+                {
+                    object->~T();
+                    m_blocks.deallocate(object);
+                }
+            }
+
+            PoolStats stats() const { return m_blocks.stats(); }
+
+        private:
+            BlockPool m_blocks;
+        };
+
+        // Power-of-two size classes from 16 bytes to MaxBlockSize, each backed by
+        // its own BlockPool. Larger requests go straight to the heap. Callers
+        // pass the original size back to deallocate(). Not thread-safe.
+        class SizeClassPool
+        {
+        public:
+            static constexpr size_t MinBlockSize = 16;
+            static constexpr size_t MaxBlockSize = 2048;
+            static constexpr size_t ClassCount = 8;
+
+            explicit SizeClassPool(MemoryTag tag = MemoryTag::General);
+            SizeClassPool(const SizeClassPool &) = delete;
+            SizeClassPool &operator=(const SizeClassPool &) = delete;
+
+            void *allocate(size_t size);
+            void deallocate(void *ptr, size_t size);
+
+            std::array<PoolStats, ClassCount> stats() const;
+            size_t oversizedLive() const { return m_oversizedLive; }
+            MemoryTag tag() const { return m_tag; }
+
+        private:
+            static size_t classIndex(size_t size);
+
+            MemoryTag m_tag;
+            std::array<std::unique_ptr<BlockPool>, ClassCount> m_classes;
+            size_t m_oversizedLive = 0;
+        };
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace xeno
+{
+    namespace pal
+    {
+        // Move-only, type-erased void() callable with 64 bytes of inline
+        // storage and no heap fallback. Constructing one from a callable that
+        // does not fit is a compile error; ThreadPool boxes such callables in
+        // pooled storage instead (see makeTask).
+        class InlineTask
+        {
+        public:
+            static constexpr size_t Capacity = 64;
+
+            InlineTask() noexcept = default;
+
+            template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, InlineTask>::value>>
+            InlineTask(F &&f)
+            {
+                using Callable = std::decay_t<F>;
+                static_assert(sizeof(Callable) <= Capacity, "Callable captures more than InlineTask::Capacity bytes");
+                static_assert(alignof(Callable) <= alignof(std::max_align_t), "Callable is over-aligned for InlineTask");
+                new (m_storage) Callable(std::forward<F>(f));
+                m_ops = &OpsFor<Callable>;
+            }
+
+            InlineTask(InlineTask &&other) noexcept
+            {
+                moveFrom(other);
+            }
+
+            InlineTask &operator=(InlineTask &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    moveFrom(other);
+                }
+                return *this;
+            }
+
+            InlineTask(const InlineTask &) = delete;
+            InlineTask &operator=(const InlineTask &) = delete;
+
+            ~InlineTask() { reset(); }
+
+            void operator()() { m_ops->invoke(m_storage); }
+            explicit operator bool() const { return m_ops != nullptr; }
+
+            void reset()
+            {
+                if (m_ops)
+                {
+                    m_ops->destroy(m_storage);
+                    m_ops = nullptr;
+                }
+            }
+
+        private:
+            struct Ops
+            {
+                void (*invoke)(void *storage);
+                void (*move)(void *to, void *from);
+                void (*destroy)(void *storage);
+            };
+
+            template <typename Callable>
+            static constexpr Ops OpsFor = {
+                [](void *storage)
+                { (*static_cast<Callable *>(storage))(); },
+                [](void *to, void *from)
+                {
+                    new (to) Callable(std::move(*static_cast<Callable *>(from)));
+                    static_cast<Callable *>(from)->~Callable();
+                },
+                [](void *storage)
+                { static_cast<Callable *>(storage)->~Callable(); }};
+
+            void moveFrom(InlineTask &other) noexcept
+            {
+                if (other.m_ops)
+                {
+                    other.m_ops->move(m_storage, other.m_storage);
+                    m_ops = other.m_ops;
+                    other.m_ops = nullptr;
+                }
+            }
+
+            alignas(std::max_align_t) unsigned char m_storage[Capacity];
+            const Ops *m_ops = nullptr;
+        };
+
+        // Thread-safe pooled storage for callables too large for InlineTask
+        void *allocateTaskStorage(size_t size);
+        void releaseTaskStorage(void *ptr, size_t size);
+
+        namespace detail
+        {
+            template <typename Callable>
+            class BoxedCallable
+            {
+            public:
+                explicit BoxedCallable(Callable *callable) : m_callable(callable) {}
+                BoxedCallable(BoxedCallable &&other) noexcept : m_callable(other.m_callable) { other.m_callable = nullptr; }
+                BoxedCallable(const BoxedCallable &) = delete;
+                ~BoxedCallable()
+                {
+                    if (m_callable)
+                    {
+                        m_callable->~Callable();
+                        releaseTaskStorage(m_callable, sizeof(Callable));
+                    }
+                }
+
+                void operator()() { (*m_callable)(); }
+
+            private:
+                Callable *m_callable;
+            };
+        }
+
+        // Wraps any void() callable in an InlineTask. Small captures are stored
+        // inline; larger ones are boxed in pooled storage. Define
+        // XENO_TASK_STRICT_CAPTURES to turn the boxed path into a compile error.
+        template <typename F>
+        InlineTask makeTask(F &&f)
+        {
+            using Callable = std::decay_t<F>;
+            static_assert(alignof(Callable) <= alignof(std::max_align_t), "Task callables must not be over-aligned");
+            if constexpr (sizeof(Callable) <= InlineTask::Capacity)
+            {
+                return InlineTask(std::forward<F>(f));
+            }
+            else
+            {
+#if defined(XENO_TASK_STRICT_CAPTURES)
+                static_assert(sizeof(Callable) <= InlineTask::Capacity, "Task capture exceeds InlineTask::Capacity");
+#endif
+                void *memory = allocateTaskStorage(sizeof(Callable));
+                Callable *callable;
+                try
+                {
+                    callable = new (memory) Callable(std::forward<F>(f));
+                }
+                catch (...)
+                {
+                    releaseTaskStorage(memory, sizeof(Callable));
+                    throw;
+                }
+                return InlineTask(detail::BoxedCallable<Callable>(callable));
+            }
+        }
+    }
+}
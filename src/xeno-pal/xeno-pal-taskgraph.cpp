@@ -0,0 +1,153 @@
+#include "xeno-pal-taskgraph.hpp"
+#include <stdexcept>
+
+namespace xeno
+{
+    namespace pal
+    {
+        TaskGraph::NodeId TaskGraph::addNode(std::string name, std::function<void()> work)
+        {
+            std::unique_ptr<Node> node = std::make_unique<Node>();
+            node->name = std::move(name);
+            node->work = std::move(work);
+            node->index = m_nodes.size();
+            m_nodes.push_back(std::move(node));
+            m_validated = false;
+            return static_cast<NodeId>(m_nodes.size() - 1);
+        }
+
+        void TaskGraph::addDependency(NodeId before, NodeId after)
+        {
+            if (before >= m_nodes.size() || after >= m_nodes.size() || before == after)
+            {
+                throw std::runtime_error("Invalid task graph dependency");
+            }
+            m_nodes[before]->successors.push_back(m_nodes[after].get());
+            ++m_nodes[after]->predecessorCount;
+            m_validated = false;
+        }
+
+        // Kahn's algorithm; anything left unvisited sits on a cycle
+        void TaskGraph::validate()
+        {
+            std::vector<uint32_t> remaining(m_nodes.size());
+            std::vector<Node *> ready;
+            for (const std::unique_ptr<Node> &node : m_nodes)
+            {
+                remaining[node->index] = node->predecessorCount;
+                if (node->predecessorCount == 0)
+                {
+                    ready.push_back(node.get());
+                }
+            }
+            size_t visited = 0;
+            while (!ready.empty())
+            {
+                Node *node = ready.back();
+                ready.pop_back();
+                ++visited;
+                for (Node *successor : node->successors)
+                {
+                    if (--remaining[successor->index] == 0)
+                    {
+                        ready.push_back(successor);
+                    }
+                }
+            }
+            if (visited != m_nodes.size())
+            {
+                throw std::runtime_error("Task graph contains a cycle");
+            }
+
+            m_timings.resize(m_nodes.size());
+            for (const std::unique_ptr<Node> &node : m_nodes)
+            {
+                m_timings[node->index].name = node->name.c_str();
+            }
+            m_validated = true;
+        }
+
+        void TaskGraph::run()
+        {
+            if (m_nodes.empty())
+            {
+                return;
+            }
+            if (!m_validated)
+            {
+                validate();
+            }
+
+            for (const std::unique_ptr<Node> &node : m_nodes)
+            {
+                node->remaining.store(node->predecessorCount, std::memory_order_relaxed);
+                m_timings[node->index].startMs = 0.0;
+                m_timings[node->index].durationMs = 0.0;
+            }
+            m_failed.store(false, std::memory_order_relaxed);
+            m_error = nullptr;
+            m_pending.store(m_nodes.size(), std::memory_order_release);
+            m_runStart = std::chrono::steady_clock::now();
+
+            for (const std::unique_ptr<Node> &node : m_nodes)
+            {
+                if (node->predecessorCount == 0)
+                {
+                    launch(node.get());
+                }
+            }
+
+            m_pool.helpUntil([this]()
+                             { return m_pending.load(std::memory_order_acquire) == 0; },
+                             ThreadPool::helpLaneFor(m_priority));
+
+            m_lastRunMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_runStart).count();
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+        }
+
+        void TaskGraph::launch(Node *node)
+        {
+            m_pool.dispatch(m_priority, [this, node]()
+                            { execute(node); });
+        }
+
+        void TaskGraph::execute(Node *node)
+        {
+            if (!m_failed.load(std::memory_order_acquire))
+            {
+                auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    if (node->work)
+                    {
+                        node->work();
+                    }
+                }
+                catch (...)
+                {
+                    if (!m_failed.exchange(true, std::memory_order_acq_rel))
+                    {
+                        m_error = std::current_exception();
+                    }
+                }
+                auto end = std::chrono::steady_clock::now();
+                NodeTiming &timing = m_timings[node->index];
+                timing.startMs = std::chrono::duration<double, std::milli>(start - m_runStart).count();
+                timing.durationMs = std::chrono::duration<double, std::milli>(end - start).count();
+            }
+
+            for (Node *successor : node->successors)
+            {
+                if (successor->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    launch(successor);
+                }
+            }
+            detail::recordFinishedTask();
+            m_pending.fetch_sub(1, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "xeno-pal.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xeno
+{
+    namespace pal
+    {
+        // Dependency graph of tasks, built once and run any number of times.
+        // run() launches every node whose predecessors have finished as soon as
+        // they finish, and the calling thread helps execute nodes until the whole
+        // graph is done, sleeping while there are none to run. Nodes can fan
+        // out further with TaskGroup/parallelFor.
+        // If a node throws, the nodes that have not started yet are skipped and
+        // run() rethrows the first exception.
+        class TaskGraph
+        {
+        public:
+            using NodeId = uint32_t;
+
+            struct NodeTiming
+            {
+                const char *name;
+                double startMs;    // relative to the start of the last run()
+                double durationMs; // 0 for nodes skipped after a failure
+            };
+
+            // Frame graphs default to the Frame lane so they overtake queued background work
+            explicit TaskGraph(ThreadPool &pool, TaskPriority priority = TaskPriority::Frame)
+                : m_pool(pool), m_priority(priority)
+            {
+            }
+            TaskGraph(const TaskGraph &) = delete;
+            TaskGraph &operator=(const TaskGraph &) = delete;
+
+            NodeId addNode(std::string name, std::function<void()> work);
+            // `after` will not start until `before` has finished
+            void addDependency(NodeId before, NodeId after);
+
+            void run();
+
+            size_t size() const { return m_nodes.size(); }
+            const std::vector<NodeTiming> &timings() const { return m_timings; }
+            double lastRunMs() const { return m_lastRunMs; }
+
+        private:
+            struct Node
+            {
+                std::string name;
+                std::function<void()> work;
+                std::vector<Node *> successors;
+                uint32_t predecessorCount = 0;
+                std::atomic<uint32_t> remaining{0};
+                size_t index = 0;
+            };
+
+            void validate();
+            void launch(Node *node);
+            void execute(Node *node);
+
+            ThreadPool &m_pool;
+            TaskPriority m_priority;
+            std::vector<std::unique_ptr<Node>> m_nodes;
+            std::vector<NodeTiming> m_timings;
+            std::atomic<size_t> m_pending{0};
+            std::atomic<bool> m_failed{false};
+            std::exception_ptr m_error;
+            std::chrono::steady_clock::time_point m_runStart;
+            double m_lastRunMs = 0.0;
+            bool m_validated = false;
+        };
+    }
+}
@@ -1,44 +1,919 @@
 #include "xeno-pal.hpp"
+#include "xeno-pal-topology.hpp"
+#include <algorithm>
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace xeno
 {
     namespace pal
     {
+        namespace
+        {
+            constexpr size_t InjectionQueueCapacity = 4096;
+
+            struct WorkerContext
+            {
+                const void *pool = nullptr;
+                void *worker = nullptr;
+            };
+
+            thread_local WorkerContext t_context;
+
+            // Background tasks running on this thread. A background task that
+            // waits on more background work already holds a slot, so it helps
+            // without taking another one.
+            thread_local size_t t_backgroundDepth = 0;
+
+            // The task runTask is executing on this thread. Its stats are
+            // recorded by whichever comes first: detail::recordFinishedTask()
+            // from the task's completion wrapper, or runTask once it returns.
+            struct RunningTask
+            {
+                ThreadPool *pool;
+                int64_t queuedNs;
+                int64_t startNs;
+                bool recorded;
+            };
+
+            thread_local RunningTask *t_runningTask = nullptr;
+
+            // Restores the enclosing task when a nested runTask unwinds
+            class RunningTaskScope
+            {
+            public:
+                explicit RunningTaskScope(RunningTask &task) : m_outer(t_runningTask) { t_runningTask = &task; }
+                ~RunningTaskScope() { t_runningTask = m_outer; }
+                RunningTaskScope(const RunningTaskScope &) = delete;
+                RunningTaskScope &operator=(const RunningTaskScope &) = delete;
+
+            private:
+                RunningTask *m_outer;
+            };
+
+            int64_t nowNs()
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            int highestBit(uint64_t value)
+            {
+#if defined(_MSC_VER)
+                unsigned long index;
+                _BitScanReverse64(&index, value);
+                return static_cast<int>(index);
+#else
+                return 63 - __builtin_clzll(value);
+#endif
+            }
+
+            // Adds to a counter. Counters owned by one worker use a plain
+            // load/store so recording stays free of locked instructions;
+            // counters shared by helper threads need the RMW.
+            void bump(std::atomic<uint64_t> &counter, uint64_t amount, bool shared)
+            {
+                if (shared)
+                {
+                    counter.fetch_add(amount, std::memory_order_relaxed);
+                }
+                else
+                {
+                    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+                }
+            }
+
+            // Log-linear histogram of nanosecond latencies: four buckets per
+            // power of two, covering the full 64-bit range in 256 counters
+            class LatencyHistogram
+            {
+            public:
+                static constexpr int SubBits = 2;
+                static constexpr size_t BucketCount = size_t(64) << SubBits;
+
+                void record(uint64_t ns, bool shared)
+                {
+                    bump(m_counts[bucketFor(ns)], 1, shared);
+                    uint64_t max = m_max.load(std::memory_order_relaxed);
+                    while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+                    {
+                    }
+                }
+
+                void addTo(std::vector<uint64_t> &counts, uint64_t &max) const
+                {
+                    counts.resize(BucketCount);
+                    for (size_t bucket = 0; bucket < BucketCount; ++bucket)
+                    {
+                        counts[bucket] += m_counts[bucket].load(std::memory_order_relaxed);
+                    }
+                    max = std::max(max, m_max.load(std::memory_order_relaxed));
+                }
+
+                static LatencySummary summarize(const std::vector<uint64_t> &counts, uint64_t max)
+                {
+                    LatencySummary summary;
+                    for (uint64_t count : counts)
+                    {
+                        summary.count += count;
+                    }
+                    if (summary.count == 0)
+                    {
+                        return summary;
+                    }
+                    summary.p50Us = percentile(counts, summary.count, 0.50, max) / 1000.0;
+                    summary.p99Us = percentile(counts, summary.count, 0.99, max) / 1000.0;
+                    summary.maxUs = max / 1000.0;
+                    return summary;
+                }
+
+            private:
+                static size_t bucketFor(uint64_t ns)
+                {
+                    if (ns < (uint64_t(1) << SubBits))
+                    {
+                        return static_cast<size_t>(ns);
+                    }
+                    int msb = highestBit(ns);
+                    size_t sub = static_cast<size_t>(ns >> (msb - SubBits)) & ((size_t(1) << SubBits) - 1);
+                    return (static_cast<size_t>(msb - SubBits + 1) << SubBits) + sub;
+                }
+
+                static uint64_t upperBound(size_t bucket)
+                {
+                    if (bucket < (size_t(1) << SubBits))
+                    {
+                        return bucket;
+                    }
+                    int shift = static_cast<int>(bucket >> SubBits) - 1;
+                    uint64_t sub = bucket & ((size_t(1) << SubBits) - 1);
+                    uint64_t lower = ((uint64_t(1) << SubBits) + sub) << shift;
+                    return lower + ((uint64_t(1) << shift) - 1);
+                }
+
+                static double percentile(const std::vector<uint64_t> &counts, uint64_t total, double q, uint64_t max)
+                {
+                    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+                    uint64_t seen = 0;
+                    for (size_t bucket = 0; bucket < counts.size(); ++bucket)
+                    {
+                        seen += counts[bucket];
+                        if (seen >= rank)
+                        {
+                            return static_cast<double>(std::min(upperBound(bucket), max));
+                        }
+                    }
+                    return static_cast<double>(max);
+                }
+
+                std::atomic<uint64_t> m_counts[BucketCount] = {};
+                std::atomic<uint64_t> m_max{0};
+            };
+
+            constexpr size_t TaskCacheBatch = 64;
+            constexpr size_t TaskSlabNodes = 1024;
+
+            // Free task nodes shared between threads. Threads only come here to
+            // refill or drain their local cache, one batch at a time.
+            struct TaskDepot
+            {
+                TaskDepot(size_t size, size_t alignment)
+                    : blocks(size, alignment, TaskSlabNodes, MemoryTag::Tasks)
+                {
+                }
+
+                std::mutex mutex;
+                std::vector<void *> free;
+                BlockPool blocks;
+            };
+
+            TaskDepot &taskDepot(size_t size, size_t alignment)
+            {
+                // Leaked on purpose: worker caches drain into it during shutdown
+                static TaskDepot *depot = new TaskDepot(size, alignment);
+                return *depot;
+            }
+
+            struct TaskCache
+            {
+                std::vector<void *> nodes;
+                TaskDepot *depot = nullptr;
+
+                ~TaskCache()
+                {
+                    if (depot && !nodes.empty())
+                    {
+                        std::lock_guard<std::mutex> lock(depot->mutex);
+                        depot->free.insert(depot->free.end(), nodes.begin(), nodes.end());
+                    }
+                }
+            };
+
+            thread_local TaskCache t_taskCache;
+
+            struct TaskStorage
+            {
+                std::mutex mutex;
+                SizeClassPool pool{MemoryTag::Tasks};
+            };
+
+            TaskStorage &taskStorage()
+            {
+                static TaskStorage *storage = new TaskStorage();
+                return *storage;
+            }
+        }
+
+        void *allocateTaskStorage(size_t size)
+        {
+            TaskStorage &storage = taskStorage();
+            std::lock_guard<std::mutex> lock(storage.mutex);
+            return storage.pool.allocate(size);
+        }
+
+        void releaseTaskStorage(void *ptr, size_t size)
+        {
+            TaskStorage &storage = taskStorage();
+            std::lock_guard<std::mutex> lock(storage.mutex);
+            storage.pool.deallocate(ptr, size);
+        }
+
+        ThreadPool::Task *ThreadPool::allocateTask()
+        {
+            TaskCache &cache = t_taskCache;
+            if (cache.nodes.empty())
+            {
+                TaskDepot &depot = taskDepot(sizeof(Task), alignof(Task));
+                if (!cache.depot)
+                {
+                    cache.depot = &depot;
+                    cache.nodes.reserve(TaskCacheBatch * 2);
+                }
+
+                std::lock_guard<std::mutex> lock(depot.mutex);
+                size_t take = depot.free.size() < TaskCacheBatch ? depot.free.size() : TaskCacheBatch;
+                cache.nodes.insert(cache.nodes.end(), depot.free.end() - take, depot.free.end());
+                depot.free.resize(depot.free.size() - take);
+                while (cache.nodes.size() < TaskCacheBatch)
+                {
+                    cache.nodes.push_back(depot.blocks.allocate());
+                }
+            }
+
+            void *memory = cache.nodes.back();
+            cache.nodes.pop_back();
+            return new (memory) Task();
+        }
+
+        void ThreadPool::releaseTask(Task *task)
+        {
+            task->~Task();
+            TaskCache &cache = t_taskCache;
+            if (!cache.depot)
+            {
+                cache.depot = &taskDepot(sizeof(Task), alignof(Task));
+                cache.nodes.reserve(TaskCacheBatch * 2);
+            }
+            cache.nodes.push_back(task);
+
+            // Threads that mostly run tasks hand surplus nodes back to the
+            // threads that mostly submit them
+            if (cache.nodes.size() >= TaskCacheBatch * 2)
+            {
+                std::lock_guard<std::mutex> lock(cache.depot->mutex);
+                cache.depot->free.insert(cache.depot->free.end(), cache.nodes.end() - TaskCacheBatch, cache.nodes.end());
+                cache.nodes.resize(cache.nodes.size() - TaskCacheBatch);
+            }
+        }
+
+        struct ThreadPool::Counters
+        {
+            explicit Counters(bool shared) : shared(shared) {}
+
+            const bool shared;
+            int64_t startNs = nowNs();
+            std::atomic<uint64_t> tasks{0};
+            std::atomic<uint64_t> steals{0};
+            std::atomic<uint64_t> busyNs{0};
+            LatencyHistogram queueWait;
+            LatencyHistogram execution;
+        };
+
+        struct ThreadPool::Worker
+        {
+            WorkStealingDeque<Task *> deques[LaneCount];
+            std::thread thread;
+            uint64_t rng;
+            std::vector<uint32_t> cpus;
+            uint32_t l3 = 0;
+            // Other workers, those sharing this worker's L3 first
+            std::vector<Worker *> victims;
+            size_t nearVictims = 0;
+            Counters counters{false};
+
+            // Written by the owning worker only
+            std::atomic<uint64_t> spinNs{0};
+            std::atomic<uint64_t> spinHits{0};
+            std::atomic<uint64_t> parks{0};
+            std::atomic<uint64_t> wakeLatencyNs{0};
+        };
+
         ThreadPool::ThreadPool(size_t num_threads)
         {
+            ThreadPoolConfig config;
+            config.workerThreads = num_threads;
+            start(config);
+        }
+
+        ThreadPool::ThreadPool(const ThreadPoolConfig &config)
+        {
+            start(config);
+        }
+
+        void ThreadPool::start(const ThreadPoolConfig &config)
+        {
+            size_t num_threads = config.workerThreads == 0 ? 1 : config.workerThreads;
+            idlePolicy_ = config.idle;
+            instrumented_ = config.instrumentation;
+            helperCounters_ = std::make_unique<Counters>(true);
+            maxBackground_ = config.maxBackgroundWorkers;
+            if (maxBackground_ == 0 || maxBackground_ > num_threads)
+            {
+                maxBackground_ = num_threads > 1 ? num_threads - 1 : 1;
+            }
+
+            for (std::unique_ptr<Lane> &lane : lanes_)
+            {
+                lane = std::make_unique<Lane>(InjectionQueueCapacity);
+            }
+            workers_.reserve(num_threads);
             for (size_t i = 0; i < num_threads; ++i)
             {
-                threads_.emplace_back([this]()
-                                      {
-                for(;;) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(mutex_);
-                        condition_.wait(lock, [this]() {
-                            return stopping_ || !tasks_.empty();
-                        });
-                        if (stopping_ && tasks_.empty()) {
-                            return;
+                workers_.push_back(std::make_unique<Worker>());
+                workers_.back()->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+            }
+            assignAffinity(config);
+
+            for (std::unique_ptr<Worker> &worker : workers_)
+            {
+                for (int near = 1; near >= 0; --near)
+                {
+                    for (std::unique_ptr<Worker> &other : workers_)
+                    {
+                        if (other != worker && (other->l3 == worker->l3) == (near == 1))
+                        {
+                            worker->victims.push_back(other.get());
                         }
-                        task = std::move(tasks_.front());
-                        tasks_.pop();
                     }
-                    task();
-                } });
+                    if (near == 1)
+                    {
+                        worker->nearVictims = worker->victims.size();
+                    }
+                }
+            }
+            // Start threads only once every deque exists, since any worker may steal from any other
+            for (std::unique_ptr<Worker> &worker : workers_)
+            {
+                Worker *self = worker.get();
+                worker->thread = std::thread([this, self]()
+                                             { workerLoop(self); });
+            }
+
+            ioThreads_.reserve(config.ioThreads);
+            for (size_t i = 0; i < config.ioThreads; ++i)
+            {
+                ioThreads_.emplace_back([this]()
+                                        { ioLoop(); });
             }
         }
 
+        void ThreadPool::assignAffinity(const ThreadPoolConfig &config)
+        {
+            const CpuTopology &topology = CpuTopology::get();
+            std::vector<bool> reserved(topology.cores.size(), false);
+            if (config.reserveMainThreadCore && !topology.cores.empty())
+            {
+                int cpu = currentCpu();
+                const LogicalCpu *logical = cpu >= 0 ? topology.find(static_cast<uint32_t>(cpu)) : nullptr;
+                uint32_t core = logical ? logical->core : 0;
+                pinCurrentThread(topology.cores[core].cpus);
+                reserved[core] = true;
+            }
+
+            if (config.affinity == WorkerAffinity::PhysicalCores)
+            {
+                std::vector<uint32_t> available;
+                for (uint32_t core = 0; core < topology.cores.size(); ++core)
+                {
+                    if (!reserved[core])
+                    {
+                        available.push_back(core);
+                    }
+                }
+                // A single-core machine has nothing left to pin to once the main thread has it
+                for (size_t i = 0; i < workers_.size() && !available.empty(); ++i)
+                {
+                    const PhysicalCore &core = topology.cores[available[i % available.size()]];
+                    workers_[i]->cpus = core.cpus;
+                    workers_[i]->l3 = core.l3;
+                }
+            }
+            else if (config.affinity == WorkerAffinity::Custom && !config.workerCpus.empty())
+            {
+                for (size_t i = 0; i < workers_.size(); ++i)
+                {
+                    Worker &worker = *workers_[i];
+                    worker.cpus = config.workerCpus[i % config.workerCpus.size()];
+                    const LogicalCpu *logical = worker.cpus.empty() ? nullptr : topology.find(worker.cpus.front());
+                    worker.l3 = logical ? logical->l3 : 0;
+                }
+            }
+        }
+
+        const std::vector<uint32_t> &ThreadPool::workerAffinity(size_t index) const
+        {
+            return workers_.at(index)->cpus;
+        }
+
         ThreadPool::~ThreadPool()
         {
+            // I/O threads go first: their queue drains into the workers' lanes
             {
-                std::unique_lock<std::mutex> lock(mutex_);
-                stopping_ = true;
+                std::lock_guard<std::mutex> lock(ioMutex_);
+                ioStopping_ = true;
             }
-            condition_.notify_all();
-            for (std::thread &thread : threads_)
+            ioCondition_.notify_all();
+            for (std::thread &thread : ioThreads_)
             {
                 thread.join();
             }
+
+            stopping_.store(true);
+            idle_.notifyAll();
+            for (std::unique_ptr<Worker> &worker : workers_)
+            {
+                worker->thread.join();
+            }
+        }
+
+        void ThreadPool::schedule(Task *task)
+        {
+            if (instrumented_)
+            {
+                task->queuedNs = nowNs();
+            }
+            size_t lane = static_cast<size_t>(task->priority);
+            if (t_context.pool == this)
+            {
+                static_cast<Worker *>(t_context.worker)->deques[lane].push(task);
+            }
+            else if (!lanes_[lane]->injection.tryPush(task))
+            {
+                Lane &target = *lanes_[lane];
+                std::lock_guard<std::mutex> lock(target.overflowMutex);
+                target.overflow.push_back(task);
+                target.overflowSize.fetch_add(1);
+            }
+
+            wakeOne();
+        }
+
+        void ThreadPool::wakeOne()
+        {
+            if (idle_.waiters() > 0)
+            {
+                lastNotifyNs_.store(nowNs(), std::memory_order_relaxed);
+            }
+            idle_.notifyOne();
+        }
+
+        void ThreadPool::scheduleIo(Task *task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(ioMutex_);
+                if (!ioThreads_.empty() && !ioStopping_)
+                {
+                    ioQueue_.push_back(task);
+                    ioCondition_.notify_one();
+                    return;
+                }
+            }
+            schedule(task);
+        }
+
+        bool ThreadPool::tryRunOne(TaskPriority lowest)
+        {
+            Worker *self = t_context.pool == this ? static_cast<Worker *>(t_context.worker) : nullptr;
+            Task *task = findTask(self, lowest);
+            if (!task)
+            {
+                return false;
+            }
+            runTask(task);
+            return true;
+        }
+
+        // self is null when a thread outside the pool is helping
+        ThreadPool::Task *ThreadPool::findTask(Worker *self, TaskPriority lowest)
+        {
+            size_t last = static_cast<size_t>(lowest);
+            for (size_t lane = 0; lane <= last; ++lane)
+            {
+                bool background = lane == static_cast<size_t>(TaskPriority::Background) && t_backgroundDepth == 0;
+                if (background)
+                {
+                    // Reserve a background slot before taking a task so at most
+                    // maxBackground_ threads are ever inside one
+                    size_t running = backgroundRunning_.load(std::memory_order_relaxed);
+                    do
+                    {
+                        if (running >= maxBackground_)
+                        {
+                            return nullptr;
+                        }
+                    } while (!backgroundRunning_.compare_exchange_weak(running, running + 1, std::memory_order_acquire, std::memory_order_relaxed));
+                }
+
+                if (Task *task = findInLane(self, lane))
+                {
+                    return task;
+                }
+                if (background)
+                {
+                    backgroundRunning_.fetch_sub(1, std::memory_order_release);
+                }
+            }
+            return nullptr;
+        }
+
+        ThreadPool::Task *ThreadPool::findInLane(Worker *self, size_t lane)
+        {
+            Lane &queue = *lanes_[lane];
+            Task *task = nullptr;
+            if ((self && self->deques[lane].pop(task)) || queue.injection.tryPop(task))
+            {
+                return task;
+            }
+
+            if (queue.overflowSize.load(std::memory_order_relaxed) > 0)
+            {
+                std::lock_guard<std::mutex> lock(queue.overflowMutex);
+                if (!queue.overflow.empty())
+                {
+                    task = queue.overflow.front();
+                    queue.overflow.pop_front();
+                    queue.overflowSize.fetch_sub(1);
+                    return task;
+                }
+            }
+
+            // xorshift64 picks where each steal sweep starts
+            thread_local uint64_t t_helperRng = 0x2545F4914F6CDD1Dull;
+            uint64_t &rng = self ? self->rng : t_helperRng;
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+
+            if (!self)
+            {
+                size_t count = workers_.size();
+                size_t start = static_cast<size_t>(rng % count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (workers_[(start + i) % count]->deques[lane].steal(task))
+                    {
+                        return task;
+                    }
+                }
+                return nullptr;
+            }
+
+            // Workers sharing our L3 first: their tasks' data is likely still warm there
+            const std::vector<Worker *> &victims = self->victims;
+            size_t groups[2][2] = {{0, self->nearVictims}, {self->nearVictims, victims.size()}};
+            for (const size_t *group : groups)
+            {
+                size_t count = group[1] - group[0];
+                if (count == 0)
+                {
+                    continue;
+                }
+                size_t start = static_cast<size_t>(rng % count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (victims[group[0] + (start + i) % count]->deques[lane].steal(task))
+                    {
+                        bump(self->counters.steals, 1, false);
+                        return task;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        bool ThreadPool::hasVisibleWork() const
+        {
+            for (size_t lane = 0; lane < LaneCount; ++lane)
+            {
+                // Background work this worker could not take anyway is not a reason to stay awake
+                if (lane == static_cast<size_t>(TaskPriority::Background) &&
+                    backgroundRunning_.load() >= maxBackground_)
+                {
+                    continue;
+                }
+                if (lanes_[lane]->injection.sizeApprox() > 0 || lanes_[lane]->overflowSize.load() > 0)
+                {
+                    return true;
+                }
+                for (const std::unique_ptr<Worker> &worker : workers_)
+                {
+                    if (worker->deques[lane].sizeApprox() > 0)
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        void ThreadPool::workerLoop(Worker *self)
+        {
+            t_context.pool = this;
+            t_context.worker = self;
+            if (!self->cpus.empty())
+            {
+                pinCurrentThread(self->cpus);
+            }
+
+            for (;;)
+            {
+                Task *task = findTask(self, TaskPriority::Background);
+                if (!task)
+                {
+                    task = waitForTask(self);
+                    if (!task)
+                    {
+                        return;
+                    }
+                }
+                runTask(task);
+            }
+        }
+
+        // Returns null once the pool is stopping and no work is left
+        ThreadPool::Task *ThreadPool::waitForTask(Worker *self)
+        {
+            // Spin, then yield: a task that arrives during the grace period is
+            // picked up without the producer paying for a futex wake
+            int64_t idleStart = nowNs();
+            uint32_t pauses = 1;
+            uint32_t rounds = idlePolicy_.spinRounds + idlePolicy_.yieldRounds;
+            for (uint32_t round = 0; round < rounds && !stopping_.load(std::memory_order_relaxed); ++round)
+            {
+                if (round < idlePolicy_.spinRounds)
+                {
+                    for (uint32_t i = 0; i < pauses; ++i)
+                    {
+                        cpuRelax();
+                    }
+                    pauses *= 2;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+
+                if (Task *task = findTask(self, TaskPriority::Background))
+                {
+                    self->spinNs.fetch_add(static_cast<uint64_t>(nowNs() - idleStart), std::memory_order_relaxed);
+                    self->spinHits.fetch_add(1, std::memory_order_relaxed);
+                    return task;
+                }
+            }
+            if (rounds > 0)
+            {
+                self->spinNs.fetch_add(static_cast<uint64_t>(nowNs() - idleStart), std::memory_order_relaxed);
+            }
+
+            for (;;)
+            {
+                uint32_t key = idle_.prepareWait();
+                if (hasVisibleWork())
+                {
+                    idle_.cancelWait();
+                }
+                else if (stopping_.load())
+                {
+                    idle_.cancelWait();
+                    return nullptr;
+                }
+                else
+                {
+                    idle_.commitWait(key);
+                    int64_t latency = nowNs() - lastNotifyNs_.load(std::memory_order_relaxed);
+                    self->parks.fetch_add(1, std::memory_order_relaxed);
+                    // Ignore stale stamps from notifies that woke someone else long ago
+                    if (latency >= 0 && latency < 100000000)
+                    {
+                        self->wakeLatencyNs.fetch_add(static_cast<uint64_t>(latency), std::memory_order_relaxed);
+                    }
+                }
+
+                if (Task *task = findTask(self, TaskPriority::Background))
+                {
+                    return task;
+                }
+            }
+        }
+
+        ThreadPool::Counters *ThreadPool::countersForCaller()
+        {
+            return t_context.pool == this ? &static_cast<Worker *>(t_context.worker)->counters : helperCounters_.get();
+        }
+
+        size_t ThreadPool::queueDepth() const
+        {
+            size_t depth = 0;
+            for (size_t lane = 0; lane < LaneCount; ++lane)
+            {
+                depth += lanes_[lane]->injection.sizeApprox() + lanes_[lane]->overflowSize.load(std::memory_order_relaxed);
+                for (const std::unique_ptr<Worker> &worker : workers_)
+                {
+                    depth += worker->deques[lane].sizeApprox();
+                }
+            }
+            return depth;
+        }
+
+        ThreadPoolStats ThreadPool::stats() const
+        {
+            ThreadPoolStats result;
+            result.queueDepth = queueDepth();
+            result.idle = idleStats();
+            if (!instrumented_)
+            {
+                return result;
+            }
+
+            int64_t now = nowNs();
+            std::vector<uint64_t> waitTotal, executionTotal;
+            uint64_t waitMaxTotal = 0, executionMaxTotal = 0;
+            auto collect = [&](const Counters &counters, WorkerStats &out)
+            {
+                out.tasksExecuted = counters.tasks.load(std::memory_order_relaxed);
+                out.steals = counters.steals.load(std::memory_order_relaxed);
+                uint64_t busyNs = counters.busyNs.load(std::memory_order_relaxed);
+                out.busyMs = busyNs / 1.0e6;
+                if (!counters.shared)
+                {
+                    int64_t lifetime = now - counters.startNs;
+                    out.idleMs = lifetime > static_cast<int64_t>(busyNs) ? (lifetime - static_cast<int64_t>(busyNs)) / 1.0e6 : 0.0;
+                }
+
+                std::vector<uint64_t> wait, execution;
+                uint64_t waitMax = 0, executionMax = 0;
+                counters.queueWait.addTo(wait, waitMax);
+                counters.execution.addTo(execution, executionMax);
+                out.queueWait = LatencyHistogram::summarize(wait, waitMax);
+                out.execution = LatencyHistogram::summarize(execution, executionMax);
+                counters.queueWait.addTo(waitTotal, waitMaxTotal);
+                counters.execution.addTo(executionTotal, executionMaxTotal);
+            };
+
+            result.workers.resize(workers_.size());
+            for (size_t i = 0; i < workers_.size(); ++i)
+            {
+                collect(workers_[i]->counters, result.workers[i]);
+            }
+            collect(*helperCounters_, result.helpers);
+            result.queueWait = LatencyHistogram::summarize(waitTotal, waitMaxTotal);
+            result.execution = LatencyHistogram::summarize(executionTotal, executionMaxTotal);
+            return result;
+        }
+
+        IdleStats ThreadPool::idleStats() const
+        {
+            IdleStats stats;
+            for (const std::unique_ptr<Worker> &worker : workers_)
+            {
+                stats.spinNs += worker->spinNs.load(std::memory_order_relaxed);
+                stats.spinHits += worker->spinHits.load(std::memory_order_relaxed);
+                stats.parks += worker->parks.load(std::memory_order_relaxed);
+                stats.wakeLatencyNs += worker->wakeLatencyNs.load(std::memory_order_relaxed);
+            }
+            return stats;
+        }
+
+        void ThreadPool::ioLoop()
+        {
+            for (;;)
+            {
+                Task *task = nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(ioMutex_);
+                    ioCondition_.wait(lock, [this]()
+                                      { return ioStopping_ || !ioQueue_.empty(); });
+                    if (ioQueue_.empty())
+                    {
+                        return;
+                    }
+                    task = ioQueue_.front();
+                    ioQueue_.pop_front();
+                }
+
+                {
+                    ArenaScope scope(scratch());
+                    task->function();
+                }
+                task->function.reset();
+                releaseTask(task);
+                finished_.notifyAll();
+            }
+        }
+
+        void ThreadPool::runTask(Task *task)
+        {
+            bool background = task->priority == TaskPriority::Background;
+            bool holdsSlot = background && t_backgroundDepth == 0;
+            t_backgroundDepth += background ? 1 : 0;
+            RunningTask running{this, task->queuedNs, instrumented_ ? nowNs() : 0, !instrumented_};
+            {
+                RunningTaskScope current(running);
+                ArenaScope scope(scratch());
+                task->function();
+            }
+            if (!running.recorded)
+            {
+                recordTask(running.queuedNs, running.startNs);
+            }
+            task->function.reset();
+            releaseTask(task);
+            finished_.notifyAll();
+            t_backgroundDepth -= background ? 1 : 0;
+            if (holdsSlot)
+            {
+                backgroundRunning_.fetch_sub(1, std::memory_order_release);
+                // A worker may have gone to sleep while the background cap was reached
+                wakeOne();
+            }
+        }
+
+        void ThreadPool::recordTask(int64_t queuedNs, int64_t startNs)
+        {
+            int64_t endNs = nowNs();
+            Counters &counters = *countersForCaller();
+            uint64_t wait = startNs > queuedNs ? static_cast<uint64_t>(startNs - queuedNs) : 0;
+            uint64_t busy = static_cast<uint64_t>(endNs - startNs);
+            bump(counters.tasks, 1, counters.shared);
+            bump(counters.busyNs, busy, counters.shared);
+            counters.queueWait.record(wait, counters.shared);
+            counters.execution.record(busy, counters.shared);
+        }
+
+        void detail::recordFinishedTask()
+        {
+            RunningTask *running = t_runningTask;
+            if (running && !running->recorded)
+            {
+                running->recorded = true;
+                running->pool->recordTask(running->queuedNs, running->startNs);
+            }
+        }
+
+        TaskGroup::~TaskGroup()
+        {
+            // Tasks still in flight reference this group
+            m_pool.helpUntil([this]()
+                             { return isDone(); },
+                             ThreadPool::helpLaneFor(m_priority));
+        }
+
+        void TaskGroup::wait()
+        {
+            m_pool.helpUntil([this]()
+                             { return isDone(); },
+                             ThreadPool::helpLaneFor(m_priority));
+
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(m_errorMutex);
+                std::swap(error, m_error);
+            }
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        void TaskGroup::captureException(std::exception_ptr error)
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            if (!m_error)
+            {
+                m_error = error;
+            }
         }
     }
-}
\ No newline at end of file
+}
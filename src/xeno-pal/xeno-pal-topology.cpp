@@ -0,0 +1,289 @@
+#include "xeno-pal-topology.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace xeno
+{
+    namespace pal
+    {
+        namespace
+        {
+            bool readLine(const std::string &path, std::string &line)
+            {
+                std::ifstream file(path);
+                return static_cast<bool>(std::getline(file, line));
+            }
+
+            bool readNumber(const std::string &path, long &value)
+            {
+                std::string line;
+                if (!readLine(path, line))
+                {
+                    return false;
+                }
+                try
+                {
+                    value = std::stol(line);
+                }
+                catch (...)
+                {
+                    return false;
+                }
+                return true;
+            }
+
+            CpuTopology flatTopology()
+            {
+                CpuTopology topology;
+                uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+                for (uint32_t cpu = 0; cpu < count; ++cpu)
+                {
+                    topology.cpus.push_back({cpu, cpu, 0, 0});
+                    topology.cores.push_back({{cpu}, 0});
+                }
+                topology.l3Domains = 1;
+                return topology;
+            }
+
+            // Key of the L3 this CPU sits behind: the lowest CPU sharing it, or
+            // the package when no L3 is described
+            long l3Key(const std::string &base, long package)
+            {
+                for (int index = 0;; ++index)
+                {
+                    std::string cache = base + "/cache/index" + std::to_string(index);
+                    long level = 0;
+                    if (!readNumber(cache + "/level", level))
+                    {
+                        break;
+                    }
+                    std::string shared;
+                    if (level == 3 && readLine(cache + "/shared_cpu_list", shared))
+                    {
+                        std::vector<uint32_t> cpus = parseCpuList(shared);
+                        if (!cpus.empty())
+                        {
+                            return static_cast<long>(*std::min_element(cpus.begin(), cpus.end()));
+                        }
+                    }
+                }
+                return -1 - package;
+            }
+
+            CpuTopology systemTopology()
+            {
+#if defined(__linux__)
+                const std::string root = "/sys/devices/system/cpu";
+                std::string online;
+                if (!readLine(root + "/online", online))
+                {
+                    return flatTopology();
+                }
+                std::vector<uint32_t> ids = parseCpuList(online);
+                if (ids.empty())
+                {
+                    return flatTopology();
+                }
+                std::sort(ids.begin(), ids.end());
+
+                CpuTopology topology;
+                std::map<std::pair<long, long>, uint32_t> coreIndex;
+                std::map<long, uint32_t> l3Index;
+                for (uint32_t id : ids)
+                {
+                    std::string base = root + "/cpu" + std::to_string(id);
+                    long package = 0;
+                    long core = static_cast<long>(id);
+                    readNumber(base + "/topology/physical_package_id", package);
+                    readNumber(base + "/topology/core_id", core);
+                    long l3 = l3Key(base, package);
+
+                    auto domain = l3Index.emplace(l3, static_cast<uint32_t>(l3Index.size())).first;
+                    auto physical = coreIndex.emplace(std::make_pair(package, core), static_cast<uint32_t>(topology.cores.size()));
+                    if (physical.second)
+                    {
+                        topology.cores.push_back({{}, domain->second});
+                    }
+                    topology.cores[physical.first->second].cpus.push_back(id);
+                    topology.cpus.push_back({id, physical.first->second, static_cast<uint32_t>(package), domain->second});
+                }
+                topology.l3Domains = l3Index.size();
+                return topology;
+#else
+                return flatTopology();
+#endif
+            }
+
+            // CPUs the process may run on, as narrowed by taskset, cpusets or
+            // a container. Empty when the platform cannot say.
+            std::vector<uint32_t> affinityCpus()
+            {
+                std::vector<uint32_t> cpus;
+#if defined(_WIN32)
+                DWORD_PTR process = 0;
+                DWORD_PTR system = 0;
+                if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system))
+                {
+                    for (uint32_t cpu = 0; cpu < sizeof(DWORD_PTR) * 8; ++cpu)
+                    {
+                        if (process & (DWORD_PTR(1) << cpu))
+                        {
+                            cpus.push_back(cpu);
+                        }
+                    }
+                }
+#elif defined(__linux__)
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (sched_getaffinity(0, sizeof(set), &set) == 0)
+                {
+                    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                    {
+                        if (CPU_ISSET(cpu, &set))
+                        {
+                            cpus.push_back(cpu);
+                        }
+                    }
+                }
+#endif
+                return cpus;
+            }
+        }
+
+        std::vector<uint32_t> parseCpuList(const std::string &list)
+        {
+            std::vector<uint32_t> cpus;
+            size_t position = 0;
+            while (position < list.size())
+            {
+                size_t comma = list.find(',', position);
+                std::string range = list.substr(position, comma == std::string::npos ? std::string::npos : comma - position);
+                position = comma == std::string::npos ? list.size() : comma + 1;
+
+                size_t dash = range.find('-');
+                try
+                {
+                    unsigned long first = std::stoul(range.substr(0, dash));
+                    unsigned long last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+                    for (unsigned long cpu = first; cpu <= last; ++cpu)
+                    {
+                        cpus.push_back(static_cast<uint32_t>(cpu));
+                    }
+                }
+                catch (...)
+                {
+                    // Blank or malformed entries are skipped
+                }
+            }
+            return cpus;
+        }
+
+        CpuTopology CpuTopology::detect()
+        {
+            CpuTopology topology = systemTopology();
+            topology.restrictTo(affinityCpus());
+            return topology;
+        }
+
+        void CpuTopology::restrictTo(const std::vector<uint32_t> &allowed)
+        {
+            CpuTopology restricted;
+            std::map<uint32_t, uint32_t> coreIndex;
+            std::map<uint32_t, uint32_t> l3Index;
+            for (const LogicalCpu &cpu : cpus)
+            {
+                if (std::find(allowed.begin(), allowed.end(), cpu.id) == allowed.end())
+                {
+                    continue;
+                }
+                auto domain = l3Index.emplace(cpu.l3, static_cast<uint32_t>(l3Index.size())).first;
+                auto physical = coreIndex.emplace(cpu.core, static_cast<uint32_t>(restricted.cores.size()));
+                if (physical.second)
+                {
+                    restricted.cores.push_back({{}, domain->second});
+                }
+                restricted.cores[physical.first->second].cpus.push_back(cpu.id);
+                restricted.cpus.push_back({cpu.id, physical.first->second, cpu.package, domain->second});
+            }
+            if (restricted.cpus.empty())
+            {
+                return;
+            }
+            restricted.l3Domains = l3Index.size();
+            *this = std::move(restricted);
+        }
+
+        const CpuTopology &CpuTopology::get()
+        {
+            static const CpuTopology topology = detect();
+            return topology;
+        }
+
+        const LogicalCpu *CpuTopology::find(uint32_t cpu) const
+        {
+            for (const LogicalCpu &logical : cpus)
+            {
+                if (logical.id == cpu)
+                {
+                    return &logical;
+                }
+            }
+            return nullptr;
+        }
+
+        bool pinCurrentThread(const std::vector<uint32_t> &cpus)
+        {
+            if (cpus.empty())
+            {
+                return false;
+            }
+#if defined(_WIN32)
+            DWORD_PTR mask = 0;
+            for (uint32_t cpu : cpus)
+            {
+                if (cpu < sizeof(DWORD_PTR) * 8)
+                {
+                    mask |= DWORD_PTR(1) << cpu;
+                }
+            }
+            return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (uint32_t cpu : cpus)
+            {
+                if (cpu < CPU_SETSIZE)
+                {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            // macOS only offers affinity hints through thread_policy_set
+            return false;
+#endif
+        }
+
+        int currentCpu()
+        {
+#if defined(_WIN32)
+            return static_cast<int>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+            return sched_getcpu();
+#else
+            return -1;
+#endif
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xeno
+{
+    namespace pal
+    {
+        struct LogicalCpu
+        {
+            uint32_t id;
+            uint32_t core;    // index into CpuTopology::cores
+            uint32_t package;
+            uint32_t l3;      // index of the L3 domain this CPU shares
+        };
+
+        struct PhysicalCore
+        {
+            std::vector<uint32_t> cpus; // SMT siblings, lowest id first
+            uint32_t l3;
+        };
+
+        // Logical CPUs grouped into physical cores and L3 domains. On Linux this
+        // is read from /sys/devices/system/cpu; elsewhere, or if /sys is not
+        // readable, every hardware thread is reported as its own core sharing a
+        // single L3.
+        // Only CPUs in the process affinity mask are reported, so taskset,
+        // cpusets and container limits shrink the topology the pool sizes
+        // itself from and pins to.
+        struct CpuTopology
+        {
+            std::vector<LogicalCpu> cpus;
+            std::vector<PhysicalCore> cores;
+            size_t l3Domains = 0;
+
+            static const CpuTopology &get();
+            static CpuTopology detect();
+
+            const LogicalCpu *find(uint32_t cpu) const;
+
+            // Drops CPUs not in allowed, along with any core or L3 domain left
+            // empty, and renumbers what remains. An allowed set that matches no
+            // CPU leaves the topology unchanged.
+            void restrictTo(const std::vector<uint32_t> &allowed);
+        };
+
+        // Parses a kernel CPU list such as "0-3,8,10-11"
+        std::vector<uint32_t> parseCpuList(const std::string &list);
+
+        // Restricts the calling thread to the given logical CPUs. Returns false
+        // when the platform does not support it or the set was rejected.
+        bool pinCurrentThread(const std::vector<uint32_t> &cpus);
+        // The logical CPU the calling thread last ran on, or -1 if unknown
+        int currentCpu();
+    }
+}
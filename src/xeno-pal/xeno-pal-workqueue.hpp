@@ -0,0 +1,423 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace xeno
+{
+    namespace pal
+    {
+        // Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+        // Work-Stealing for Weak Memory Models"). The owning thread pushes and
+        // pops at the bottom; any other thread may steal from the top. Items
+        // must be trivially copyable (task pointers in practice). Arrays that
+        // are outgrown are kept until destruction so a concurrent thief never
+        // reads freed memory.
+        template <typename T>
+        class WorkStealingDeque
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque items must be trivially copyable");
+
+        public:
+            explicit WorkStealingDeque(size_t capacity = 256)
+            {
+                if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+                {
+                    throw std::runtime_error("WorkStealingDeque capacity must be a power of two");
+                }
+                m_arrays.push_back(std::make_unique<Array>(static_cast<int64_t>(capacity)));
+                m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+            }
+
+            WorkStealingDeque(const WorkStealingDeque &) = delete;
+            WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+            // Owner only
+            void push(T item)
+            {
+                int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+                int64_t top = m_top.load(std::memory_order_acquire);
+                Array *array = m_array.load(std::memory_order_relaxed);
+                if (bottom - top > array->capacity - 1)
+                {
+                    array = grow(array, top, bottom);
+                }
+                array->put(bottom, item);
+                // Release on bottom (rather than a standalone fence) publishes the
+                // item to thieves that acquire-load bottom in steal()
+                m_bottom.store(bottom + 1, std::memory_order_release);
+            }
+
+            // Owner only
+            bool pop(T &out)
+            {
+                int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+                Array *array = m_array.load(std::memory_order_relaxed);
+                m_bottom.store(bottom, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                int64_t top = m_top.load(std::memory_order_relaxed);
+
+                if (top > bottom)
+                {
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                out = array->get(bottom);
+                if (top == bottom)
+                {
+                    // Last item: race any thief for it
+                    bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return won;
+                }
+                return true;
+            }
+
+            // Any thread
+            bool steal(T &out)
+            {
+                int64_t top = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                int64_t bottom = m_bottom.load(std::memory_order_acquire);
+                if (top >= bottom)
+                {
+                    return false;
+                }
+                Array *array = m_array.load(std::memory_order_acquire);
+                T item = array->get(top);
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                out = item;
+                return true;
+            }
+
+            size_t sizeApprox() const
+            {
+                int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+                int64_t top = m_top.load(std::memory_order_relaxed);
+                return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+            }
+
+        private:
+            struct Array
+            {
+                explicit Array(int64_t size)
+                    : capacity(size), mask(size - 1), items(new std::atomic<T>[static_cast<size_t>(size)])
+                {
+                }
+
+                T get(int64_t index) const { return items[index & mask].load(std::memory_order_relaxed); }
+                void put(int64_t index, T item) { items[index & mask].store(item, std::memory_order_relaxed); }
+
+                int64_t capacity;
+                int64_t mask;
+                std::unique_ptr<std::atomic<T>[]> items;
+            };
+
+            Array *grow(Array *array, int64_t top, int64_t bottom)
+            {
+                m_arrays.push_back(std::make_unique<Array>(array->capacity * 2));
+                Array *bigger = m_arrays.back().get();
+                for (int64_t i = top; i < bottom; ++i)
+                {
+                    bigger->put(i, array->get(i));
+                }
+                m_array.store(bigger, std::memory_order_release);
+                return bigger;
+            }
+
+            alignas(64) std::atomic<int64_t> m_top{0};
+            alignas(64) std::atomic<int64_t> m_bottom{0};
+            alignas(64) std::atomic<Array *> m_array{nullptr};
+            std::vector<std::unique_ptr<Array>> m_arrays; // owner only
+        };
+
+        // Bounded single-producer/single-consumer ring, e.g. render command
+        // handoff or input events. Head and tail live on their own cache lines,
+        // and each side keeps a private copy of the other side's index, so the
+        // shared line is only read when the ring looks full (producer) or
+        // empty (consumer). Release on the index store publishes the slot;
+        // acquire on the other side's load makes it visible.
+        template <typename T>
+        class SpscQueue
+        {
+        public:
+            explicit SpscQueue(size_t capacity)
+            {
+                if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+                {
+                    throw std::runtime_error("SpscQueue capacity must be a power of two");
+                }
+                m_items.reset(new T[capacity]);
+                m_mask = capacity - 1;
+            }
+
+            SpscQueue(const SpscQueue &) = delete;
+            SpscQueue &operator=(const SpscQueue &) = delete;
+
+            // Producer only
+            bool tryPush(T item)
+            {
+                size_t tail = m_tail.load(std::memory_order_relaxed);
+                if (tail - m_cachedHead > m_mask)
+                {
+                    m_cachedHead = m_head.load(std::memory_order_acquire);
+                    if (tail - m_cachedHead > m_mask)
+                    {
+                        return false; // full
+                    }
+                }
+                m_items[tail & m_mask] = std::move(item);
+                m_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer only
+            bool tryPop(T &out)
+            {
+                size_t head = m_head.load(std::memory_order_relaxed);
+                if (head == m_cachedTail)
+                {
+                    m_cachedTail = m_tail.load(std::memory_order_acquire);
+                    if (head == m_cachedTail)
+                    {
+                        return false; // empty
+                    }
+                }
+                out = std::move(m_items[head & m_mask]);
+                m_head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            size_t sizeApprox() const
+            {
+                size_t tail = m_tail.load(std::memory_order_relaxed);
+                size_t head = m_head.load(std::memory_order_relaxed);
+                return tail > head ? tail - head : 0;
+            }
+
+            size_t capacity() const { return m_mask + 1; }
+
+        private:
+            std::unique_ptr<T[]> m_items;
+            size_t m_mask = 0;
+            alignas(64) std::atomic<size_t> m_head{0}; // next slot to pop
+            size_t m_cachedTail = 0;                    // consumer's view of m_tail
+            alignas(64) std::atomic<size_t> m_tail{0}; // next slot to push
+            size_t m_cachedHead = 0;                    // producer's view of m_head
+        };
+
+        // Bounded multi-producer/multi-consumer queue (Vyukov). Each cell carries
+        // a sequence number that tells producers and consumers whose turn it is,
+        // so push and pop are a single CAS on their respective index. The
+        // acquire load of a cell's sequence pairs with the release store that
+        // handed the cell over, which is what publishes the item; the index
+        // CAS itself only arbitrates between threads on the same side.
+        template <typename T>
+        class MpmcQueue
+        {
+        public:
+            explicit MpmcQueue(size_t capacity)
+            {
+                if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+                {
+                    throw std::runtime_error("MpmcQueue capacity must be a power of two");
+                }
+                m_cells.reset(new Cell[capacity]);
+                m_mask = capacity - 1;
+                for (size_t i = 0; i < capacity; ++i)
+                {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            MpmcQueue(const MpmcQueue &) = delete;
+            MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+            bool tryPush(T item)
+            {
+                size_t position = m_enqueuePos.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    Cell &cell = m_cells[position & m_mask];
+                    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                    if (diff == 0)
+                    {
+                        if (m_enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            cell.item = std::move(item);
+                            cell.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        return false; // full
+                    }
+                    else
+                    {
+                        position = m_enqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool tryPop(T &out)
+            {
+                size_t position = m_dequeuePos.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    Cell &cell = m_cells[position & m_mask];
+                    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+                    if (diff == 0)
+                    {
+                        if (m_dequeuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            out = std::move(cell.item);
+                            cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        return false; // empty
+                    }
+                    else
+                    {
+                        position = m_dequeuePos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            size_t sizeApprox() const
+            {
+                size_t enqueued = m_enqueuePos.load(std::memory_order_relaxed);
+                size_t dequeued = m_dequeuePos.load(std::memory_order_relaxed);
+                return enqueued > dequeued ? enqueued - dequeued : 0;
+            }
+
+            size_t capacity() const { return m_mask + 1; }
+
+        private:
+            struct Cell
+            {
+                std::atomic<size_t> sequence;
+                T item;
+            };
+
+            std::unique_ptr<Cell[]> m_cells;
+            size_t m_mask = 0;
+            alignas(64) std::atomic<size_t> m_enqueuePos{0};
+            alignas(64) std::atomic<size_t> m_dequeuePos{0};
+        };
+
+        // Tells the core we are in a spin-wait so it can yield pipeline
+        // resources to an SMT sibling and save power
+        inline void cpuRelax()
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield");
+#endif
+        }
+
+        // Eventcount: lets a thread re-check a condition after announcing that
+        // it is about to sleep, so notifiers only touch the mutex when someone
+        // is actually waiting. Waiters do
+        //
+        //     key = prepareWait(); if (condition) cancelWait(); else commitWait(key);
+        //
+        // and notifiers make the condition true before calling notify.
+        class EventCount
+        {
+        public:
+            uint32_t prepareWait()
+            {
+                return static_cast<uint32_t>(m_state.fetch_add(1, std::memory_order_seq_cst) >> EpochShift);
+            }
+
+            void cancelWait()
+            {
+                m_state.fetch_sub(1, std::memory_order_seq_cst);
+            }
+
+            void commitWait(uint32_t key)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (static_cast<uint32_t>(m_state.load(std::memory_order_seq_cst) >> EpochShift) == key)
+                {
+                    m_condition.wait(lock);
+                }
+                m_state.fetch_sub(1, std::memory_order_seq_cst);
+            }
+
+            // commitWait that also returns once timeout has passed
+            template <typename Rep, typename Period>
+            void commitWaitFor(uint32_t key, std::chrono::duration<Rep, Period> timeout)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait_for(lock, timeout, [this, key]()
+                                     { return static_cast<uint32_t>(m_state.load(std::memory_order_seq_cst) >> EpochShift) != key; });
+                m_state.fetch_sub(1, std::memory_order_seq_cst);
+            }
+
+            void notifyOne() { notify(false); }
+            void notifyAll() { notify(true); }
+
+            uint32_t waiters() const
+            {
+                return static_cast<uint32_t>(m_state.load(std::memory_order_relaxed) & WaiterMask);
+            }
+
+        private:
+            static constexpr int EpochShift = 32;
+            static constexpr uint64_t WaiterMask = (uint64_t(1) << EpochShift) - 1;
+
+            void notify(bool all)
+            {
+                // Pairs with the RMW in prepareWait: either we see the waiter, or
+                // the waiter sees the condition when it re-checks
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if ((m_state.load(std::memory_order_relaxed) & WaiterMask) == 0)
+                {
+                    return;
+                }
+                m_state.fetch_add(uint64_t(1) << EpochShift, std::memory_order_seq_cst);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (all)
+                {
+                    m_condition.notify_all();
+                }
+                else
+                {
+                    m_condition.notify_one();
+                }
+            }
+
+            std::atomic<uint64_t> m_state{0}; // epoch << 32 | waiters
+            std::mutex m_mutex;
+            std::condition_variable m_condition;
+        };
+    }
+}
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
 #include <vector>
 #include <GLFW/glfw3.h>
 #include <string>
@@ -8,11 +13,20 @@
 #include <functional>
 #include <fstream>
 #include <thread>
-#include <queue>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <type_traits>
 #include <mutex>
 #include <condition_variable>
 #define GLFW_INCLUDE_VULKAN
 
+#include "xeno-pal-logger.hpp"
+#include "xeno-pal-memory.hpp"
+#include "xeno-pal-pool.hpp"
+#include "xeno-pal-task.hpp"
+#include "xeno-pal-workqueue.hpp"
+
 namespace xeno
 {
     namespace pal
@@ -93,6 +107,7 @@ namespace xeno
             void open();
             void close();
             std::vector<char> read(size_t size);
+            std::pmr::vector<char> read(size_t size, std::pmr::memory_resource *resource);
             bool isOpen() const;
 
         private:
@@ -121,72 +136,540 @@ namespace xeno
         class Arena
         {
         public:
-            Arena(size_t size);
+            // Opaque savepoint returned by mark(); rewinding to it releases
+            // everything allocated after the mark was taken.
+            struct Marker
+            {
+                size_t offset;
+            };
+
+            // Reserve-then-commit mode: reserveSize bytes of address space are
+            // reserved up front, pages are committed in commitChunk steps as the
+            // offset grows, and reset() hands everything above retainOnReset
+            // back to the OS. reserveSize must be set.
+            struct VirtualConfig
+            {
+                size_t reserveSize = 0;
+                size_t commitChunk = 64 * 1024;
+                size_t retainOnReset = 1024 * 1024;
+                MemoryTag tag = MemoryTag::General;
+            };
+
+            static constexpr size_t DefaultAlignment = alignof(std::max_align_t);
+
+            Arena(size_t size, MemoryTag tag = MemoryTag::General);
+            explicit Arena(const VirtualConfig &config);
             ~Arena();
             Arena(const Arena &) = delete;
             Arena &operator=(const Arena &) = delete;
 
-            void *allocate(size_t size);
+            void *allocate(size_t size, size_t alignment = DefaultAlignment);
 
             template <class T>
             T *alloc(size_t count)
             {
-                return static_cast<T *>(allocate(sizeof(T) * count));
+                return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
             }
 
+            Marker mark() const { return Marker{m_offset}; }
+            void rewind(Marker marker);
+            // Like rewind(), but leaves the arena alone if it is already below
+            // marker (reset or rewound further since the mark). For destructors.
+            void unwind(Marker marker) noexcept;
             void reset();
 
+            size_t used() const { return m_offset; }
+            size_t capacity() const { return m_size; }
+            size_t committed() const { return m_committed; }
+            size_t highWaterMark() const { return m_highWater; }
+            bool isVirtual() const { return m_virtual; }
+            MemoryTag tag() const { return m_tag; }
+
         private:
+            void commit(size_t required);
+            void decommit(size_t keep);
+
             char *m_memory;
             size_t m_size;
             size_t m_offset;
+            size_t m_highWater;
+            size_t m_committed;
+            size_t m_commitChunk = 0;
+            size_t m_retainOnReset = 0;
+            MemoryTag m_tag;
+            bool m_virtual = false;
+        };
+
+        // Rolls the arena back to where it was when the scope was opened. A
+        // reset() inside the scope is left as it is.
+        class ArenaScope
+        {
+        public:
+            explicit ArenaScope(Arena &arena) : m_arena(arena), m_marker(arena.mark()) {}
+            ~ArenaScope() { m_arena.unwind(m_marker); }
+            ArenaScope(const ArenaScope &) = delete;
+            ArenaScope &operator=(const ArenaScope &) = delete;
+
+        private:
+            Arena &m_arena;
+            Arena::Marker m_marker;
+        };
+
+        // Per-thread scratch arena, created on first use. ThreadPool workers
+        // rewind theirs after every task; other threads should bracket their
+        // use with an ArenaScope.
+        Arena &scratch();
+
+        // One arena per frame in flight. beginFrame(i) must only be called once
+        // the GPU has retired frame i, at which point everything allocated from
+        // that frame's arena is released in one go.
+        class FrameArenas
+        {
+        public:
+            FrameArenas(uint32_t frameCount, const Arena::VirtualConfig &config);
+            FrameArenas(const FrameArenas &) = delete;
+            FrameArenas &operator=(const FrameArenas &) = delete;
+
+            void beginFrame(uint32_t frameIndex);
+            Arena &current() { return *m_arenas[m_frameIndex]; }
+            Arena &frame(uint32_t frameIndex) { return *m_arenas[frameIndex]; }
+            uint32_t frameIndex() const { return m_frameIndex; }
+            uint32_t frameCount() const { return static_cast<uint32_t>(m_arenas.size()); }
+
+        private:
+            std::vector<std::unique_ptr<Arena>> m_arenas;
+            uint32_t m_frameIndex = 0;
+        };
+
+        class ThreadPool;
+
+        namespace detail
+        {
+            // Records ThreadPool stats for the task running on this thread, so
+            // they are visible in stats() before its completion is. Completion
+            // wrappers call it just before they signal; otherwise the pool
+            // records the task once it returns.
+            void recordFinishedTask();
+        }
+
+        // Workers always take the highest non-empty lane first. Background work
+        // is additionally capped to ThreadPoolConfig::maxBackgroundWorkers
+        // workers, and threads that help while waiting never pick it up unless
+        // they are waiting on background work themselves, so a long streaming
+        // job cannot hold up frame-critical tasks.
+        enum class TaskPriority : uint8_t
+        {
+            Frame,
+            Normal,
+            Background,
+            Count
+        };
+
+        enum class WorkerAffinity : uint8_t
+        {
+            None,          // let the OS schedule workers anywhere
+            PhysicalCores, // one physical core (all its SMT siblings) per worker
+            Custom         // ThreadPoolConfig::workerCpus
+        };
+
+        // How an idle worker waits before parking. It first spins with
+        // exponential backoff (1, 2, 4, ... pause instructions between checks for
+        // spinRounds rounds), then yields its time slice yieldRounds times, and
+        // only then sleeps until notified. Zero rounds parks immediately.
+        struct IdlePolicy
+        {
+            uint32_t spinRounds = 8;
+            uint32_t yieldRounds = 4;
+        };
+
+        // Totals across all workers since the pool was created
+        struct IdleStats
+        {
+            uint64_t spinNs = 0;        // time spent spinning or yielding while idle
+            uint64_t spinHits = 0;      // idle periods that found work before parking
+            uint64_t parks = 0;         // idle periods that went to sleep
+            uint64_t wakeLatencyNs = 0; // summed notify-to-running delay of parked workers
+
+            double averageWakeLatencyUs() const { return parks ? wakeLatencyNs / 1000.0 / parks : 0.0; }
+            // Wake latency the spin phase avoided, assuming each hit would
+            // otherwise have paid the average parked wake-up
+            double savedLatencyMs() const { return spinHits * averageWakeLatencyUs() / 1000.0; }
+            double spinMs() const { return spinNs / 1.0e6; }
+        };
+
+        struct LatencySummary
+        {
+            uint64_t count = 0;
+            double p50Us = 0.0;
+            double p99Us = 0.0;
+            double maxUs = 0.0;
+        };
+
+        struct WorkerStats
+        {
+            uint64_t tasksExecuted = 0;
+            uint64_t steals = 0;
+            double busyMs = 0.0;
+            double idleMs = 0.0;         // lifetime minus busy; 0 for helper threads
+            LatencySummary queueWait;    // submission to start of execution
+            LatencySummary execution;
+        };
+
+        // Snapshot of ThreadPool instrumentation since the pool was created.
+        // Percentiles come from log-linear histograms and are accurate to
+        // within a quarter of their power-of-two range.
+        struct ThreadPoolStats
+        {
+            std::vector<WorkerStats> workers;
+            WorkerStats helpers; // tasks run by non-worker threads while waiting
+            LatencySummary queueWait;
+            LatencySummary execution;
+            size_t queueDepth = 0;
+            IdleStats idle;
+        };
+
+        struct ThreadPoolConfig
+        {
+            size_t workerThreads = std::thread::hardware_concurrency();
+            WorkerAffinity affinity = WorkerAffinity::None;
+            // Custom affinity: CPU set for worker i, reused round-robin
+            std::vector<std::vector<uint32_t>> workerCpus;
+            // Pins the constructing thread to the core it is running on and
+            // keeps PhysicalCores workers off that core
+            bool reserveMainThreadCore = false;
+            IdlePolicy idle;
+            // Threads dedicated to blocking I/O (enqueueIo/dispatchIo). With none,
+            // I/O tasks run in the Background lane.
+            size_t ioThreads = 0;
+            // 0 allows all but one worker to run Background tasks at once
+            size_t maxBackgroundWorkers = 0;
+            // Per-task timestamps and histograms; roughly two clock reads per task
+            bool instrumentation = true;
+        };
+
+        // Shared completion state behind a TaskHandle
+        template <typename R>
+        struct TaskState
+        {
+            std::atomic<bool> ready{false};
+            std::optional<R> value;
+            std::exception_ptr error;
+
+            template <typename F>
+            void run(F &function)
+            {
+                try
+                {
+                    value.emplace(function());
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                detail::recordFinishedTask();
+                ready.store(true, std::memory_order_release);
+            }
+        };
+
+        template <>
+        struct TaskState<void>
+        {
+            std::atomic<bool> ready{false};
+            std::exception_ptr error;
+
+            template <typename F>
+            void run(F &function)
+            {
+                try
+                {
+                    function();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                detail::recordFinishedTask();
+                ready.store(true, std::memory_order_release);
+            }
+        };
+
+        // Result of ThreadPool::enqueue. wait() runs other queued tasks until
+        // this one has finished, and sleeps once there are none to run.
+        template <typename R>
+        class TaskHandle
+        {
+        public:
+            TaskHandle() = default;
+            TaskHandle(ThreadPool *pool, std::shared_ptr<TaskState<R>> state, TaskPriority helpUpTo)
+                : m_pool(pool), m_state(std::move(state)), m_helpUpTo(helpUpTo)
+            {
+            }
+
+            bool valid() const { return m_state != nullptr; }
+            bool isReady() const { return m_state->ready.load(std::memory_order_acquire); }
+            void wait() const;
+
+            // Waits, then returns the result or rethrows the task's exception
+            R get();
+
+        private:
+            ThreadPool *m_pool = nullptr;
+            std::shared_ptr<TaskState<R>> m_state;
+            TaskPriority m_helpUpTo = TaskPriority::Normal;
         };
 
+        // Work-stealing thread pool. Each worker owns a Chase-Lev deque: tasks
+        // enqueued from a worker go to its own deque, tasks from any other thread
+        // go through a lock-free injection queue, and idle workers steal from a
+        // random victim. Idle workers spin briefly before parking on an
+        // eventcount (see IdlePolicy).
         class ThreadPool
         {
         public:
             ThreadPool(size_t numThreads = std::thread::hardware_concurrency());
+            explicit ThreadPool(const ThreadPoolConfig &config);
             ~ThreadPool();
+            ThreadPool(const ThreadPool &) = delete;
+            ThreadPool &operator=(const ThreadPool &) = delete;
+
             template <typename F>
-            void enqueue(F &&f)
+            auto enqueue(F &&f) -> TaskHandle<std::invoke_result_t<std::decay_t<F> &>>
             {
+                return enqueue(TaskPriority::Normal, std::forward<F>(f));
+            }
+
+            template <typename F>
+            auto enqueue(TaskPriority priority, F &&f) -> TaskHandle<std::invoke_result_t<std::decay_t<F> &>>
+            {
+                using Result = std::invoke_result_t<std::decay_t<F> &>;
+                std::shared_ptr<TaskState<Result>> state = std::make_shared<TaskState<Result>>();
+                dispatch(priority, [state, function = std::forward<F>(f)]() mutable
+                         { state->run(function); });
+                return TaskHandle<Result>(this, std::move(state), helpLaneFor(priority));
+            }
+
+            // Runs on a dedicated I/O thread so blocking calls never occupy a worker
+            template <typename F>
+            auto enqueueIo(F &&f) -> TaskHandle<std::invoke_result_t<std::decay_t<F> &>>
+            {
+                using Result = std::invoke_result_t<std::decay_t<F> &>;
+                std::shared_ptr<TaskState<Result>> state = std::make_shared<TaskState<Result>>();
+                dispatchIo([state, function = std::forward<F>(f)]() mutable
+                           { state->run(function); });
+                return TaskHandle<Result>(this, std::move(state), TaskPriority::Normal);
+            }
+
+            // Fire-and-forget submission. Task nodes are recycled through
+            // per-thread caches and captures up to InlineTask::Capacity bytes
+            // are stored inline, so in steady state this does not allocate.
+            template <typename F>
+            void dispatch(F &&f)
+            {
+                dispatch(TaskPriority::Normal, std::forward<F>(f));
+            }
+
+            template <typename F>
+            void dispatch(TaskPriority priority, F &&f)
+            {
+                Task *task = allocateTask();
+                task->function = makeTask(std::forward<F>(f));
+                task->priority = priority;
+                schedule(task);
+            }
+
+            template <typename F>
+            void dispatchIo(F &&f)
+            {
+                Task *task = allocateTask();
+                task->function = makeTask(std::forward<F>(f));
+                task->priority = TaskPriority::Background;
+                scheduleIo(task);
+            }
+
+            // Runs one queued task from lanes up to and including `lowest` on the
+            // calling thread, if there is one. This is how waiting threads help
+            // instead of blocking.
+            bool tryRunOne(TaskPriority lowest = TaskPriority::Normal);
+
+            // Runs queued tasks from lanes up to `lowest` until done() holds.
+            // When there is nothing to run for a few rounds the caller parks
+            // until some task finishes. The park is bounded, so work queued
+            // while every worker is itself waiting still gets picked up.
+            template <typename Done>
+            void helpUntil(Done done, TaskPriority lowest)
+            {
+                uint32_t idleRounds = 0;
+                while (!done())
                 {
-                    std::unique_lock<std::mutex> lock(mutex_);
-                    tasks_.emplace(std::forward<F>(f));
-                    condition_.notify_one();
+                    if (tryRunOne(lowest))
+                    {
+                        idleRounds = 0;
+                    }
+                    else if (++idleRounds < HelpYieldRounds)
+                    {
+                        std::this_thread::yield();
+                    }
+                    else
+                    {
+                        uint32_t key = finished_.prepareWait();
+                        if (done())
+                        {
+                            finished_.cancelWait();
+                        }
+                        else
+                        {
+                            finished_.commitWaitFor(key, HelpParkTimeout);
+                        }
+                    }
                 }
             }
 
+            size_t size() const { return workers_.size(); }
+            size_t ioThreadCount() const { return ioThreads_.size(); }
+            // CPUs worker `index` is pinned to; empty when it is unpinned
+            const std::vector<uint32_t> &workerAffinity(size_t index) const;
+            IdleStats idleStats() const;
+            // Only idle stats and queue depth unless ThreadPoolConfig::instrumentation is set.
+            // A task is counted before its TaskGroup, TaskHandle or TaskGraph
+            // reports it finished, so stats() after wait() includes it.
+            ThreadPoolStats stats() const;
+            size_t queueDepth() const;
+
+            // Lowest lane worth helping with while waiting on a task of this priority
+            static TaskPriority helpLaneFor(TaskPriority priority)
+            {
+                return priority == TaskPriority::Background ? TaskPriority::Background : TaskPriority::Normal;
+            }
+
         private:
-            std::vector<std::thread> threads_;
-            std::queue<std::function<void()>> tasks_;
-            std::mutex mutex_;
-            std::condition_variable condition_;
-            bool stopping_ = false;
+            static constexpr size_t LaneCount = static_cast<size_t>(TaskPriority::Count);
+            static constexpr uint32_t HelpYieldRounds = 64;
+            static constexpr std::chrono::milliseconds HelpParkTimeout{1};
+
+            struct Task
+            {
+                InlineTask function;
+                TaskPriority priority = TaskPriority::Normal;
+                int64_t queuedNs = 0;
+            };
+            struct Counters;
+            struct Worker;
+
+            struct Lane
+            {
+                explicit Lane(size_t capacity) : injection(capacity) {}
+
+                MpmcQueue<Task *> injection;
+                std::mutex overflowMutex;
+                std::deque<Task *> overflow;
+                std::atomic<size_t> overflowSize{0};
+            };
+
+            static Task *allocateTask();
+            static void releaseTask(Task *task);
+
+            void start(const ThreadPoolConfig &config);
+            void assignAffinity(const ThreadPoolConfig &config);
+            void schedule(Task *task);
+            void scheduleIo(Task *task);
+            Task *findTask(Worker *self, TaskPriority lowest);
+            Task *findInLane(Worker *self, size_t lane);
+            bool hasVisibleWork() const;
+            void workerLoop(Worker *self);
+            Task *waitForTask(Worker *self);
+            void wakeOne();
+            Counters *countersForCaller();
+            void recordTask(int64_t queuedNs, int64_t startNs);
+            friend void detail::recordFinishedTask();
+            void ioLoop();
+            void runTask(Task *task);
+
+            std::vector<std::unique_ptr<Worker>> workers_;
+            std::unique_ptr<Lane> lanes_[LaneCount];
+            size_t maxBackground_ = 1;
+            std::atomic<size_t> backgroundRunning_{0};
+            IdlePolicy idlePolicy_;
+            bool instrumented_ = false;
+            std::unique_ptr<Counters> helperCounters_;
+            EventCount idle_;
+            EventCount finished_; // signalled after every task, for helpUntil()
+            // steady_clock time of the last notify, for measuring wake latency
+            std::atomic<int64_t> lastNotifyNs_{0};
+            std::atomic<bool> stopping_{false};
+
+            std::vector<std::thread> ioThreads_;
+            std::deque<Task *> ioQueue_;
+            std::mutex ioMutex_;
+            std::condition_variable ioCondition_;
+            bool ioStopping_ = false;
         };
 
-        class Logger
+        // Fork/join counter. run() forks work onto the pool; wait() helps run
+        // queued tasks until every forked task has finished, then rethrows the
+        // first exception any of them raised. Safe to call from inside a task.
+        class TaskGroup
         {
         public:
-            enum class LogLevel
+            explicit TaskGroup(ThreadPool &pool, TaskPriority priority = TaskPriority::Normal)
+                : m_pool(pool), m_priority(priority)
             {
-                Info,
-                Warning,
-                Error
-            };
+            }
+            ~TaskGroup();
+            TaskGroup(const TaskGroup &) = delete;
+            TaskGroup &operator=(const TaskGroup &) = delete;
 
-            Logger(const std::string &filename);
-            ~Logger();
+            template <typename F>
+            void run(F &&f)
+            {
+                m_pending.fetch_add(1, std::memory_order_relaxed);
+                m_pool.dispatch(m_priority, [this, function = std::forward<F>(f)]() mutable
+                                {
+                                    try
+                                    {
+                                        function();
+                                    }
+                                    catch (...)
+                                    {
+                                        captureException(std::current_exception());
+                                    }
+                                    detail::recordFinishedTask();
+                                    m_pending.fetch_sub(1, std::memory_order_acq_rel);
+                                });
+            }
 
-            void log(const std::string &message, LogLevel level = LogLevel::Info);
-            void flush();
-            void logInfo(const std::string &message);
-            void logWarning(const std::string &message);
-            void logError(const std::string &message);
+            void wait();
+            bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
 
         private:
-            std::ofstream m_logFile;
-            std::mutex m_logMutex;
+            void captureException(std::exception_ptr error);
+
+            ThreadPool &m_pool;
+            TaskPriority m_priority;
+            std::atomic<size_t> m_pending{0};
+            std::mutex m_errorMutex;
+            std::exception_ptr m_error;
         };
+
+        template <typename R>
+        void TaskHandle<R>::wait() const
+        {
+            m_pool->helpUntil([this]()
+                              { return isReady(); },
+                              m_helpUpTo);
+        }
+
+        template <typename R>
+        R TaskHandle<R>::get()
+        {
+            wait();
+            if (m_state->error)
+            {
+                std::rethrow_exception(m_state->error);
+            }
+            if constexpr (!std::is_void<R>::value)
+            {
+                return std::move(*m_state->value);
+            }
+        }
     }
 }
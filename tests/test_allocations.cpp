@@ -0,0 +1,182 @@
+// Checks that hot paths stay off the heap. Built as its own executable
+// because it replaces the global allocation functions, which would
+// otherwise count (and intercept) every allocation in xeno_tests.
+#include "xeno-pal/xeno-pal.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+    thread_local size_t t_heapAllocations = 0;
+
+    void *countedAlloc(size_t size)
+    {
+        ++t_heapAllocations;
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+    void *countedAlignedAlloc(size_t size, std::align_val_t alignment)
+    {
+        ++t_heapAllocations;
+        size_t align = static_cast<size_t>(alignment);
+        size = (size + align - 1) & ~(align - 1);
+#if defined(_WIN32)
+        return _aligned_malloc(size > 0 ? size : align, align);
+#else
+        return std::aligned_alloc(align, size > 0 ? size : align);
+#endif
+    }
+
+    void alignedFree(void *ptr)
+    {
+#if defined(_WIN32)
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+void *operator new(size_t size)
+{
+    if (void *ptr = countedAlloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    if (void *ptr = countedAlignedAlloc(size, alignment))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return ::operator new(size, alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return countedAlignedAlloc(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return countedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { alignedFree(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { alignedFree(ptr); }
+
+void test_task_submission_allocations()
+{
+    xeno::pal::ThreadPool pool(1);
+    std::atomic<int> executed{0};
+    auto batch = [&]()
+    {
+        xeno::pal::TaskGroup group(pool);
+        for (int i = 0; i < 1000; ++i)
+        {
+            group.run([&executed]()
+                      { executed.fetch_add(1, std::memory_order_relaxed); });
+        }
+        group.wait();
+    };
+
+    // Warm the task node pool past any later batch's peak. The worker is
+    // held until every task is queued, so all of these nodes are live at once
+    // and there is room left over for the nodes parked in thread caches.
+    {
+        std::atomic<bool> started{false};
+        std::atomic<bool> release{false};
+        xeno::pal::TaskGroup group(pool);
+        group.run([&started, &release]()
+                  {
+            started = true;
+            while (!release)
+            {
+                std::this_thread::yield();
+            } });
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 2000; ++i)
+        {
+            group.run([&executed]()
+                      { executed.fetch_add(1, std::memory_order_relaxed); });
+        }
+        release = true;
+        group.wait();
+    }
+
+    size_t before = t_heapAllocations;
+    for (int i = 0; i < 10; ++i)
+    {
+        batch();
+    }
+    size_t after = t_heapAllocations;
+    if (executed != 12000)
+    {
+        throw std::runtime_error("Task allocation test failed: tasks lost");
+    }
+    if (after != before)
+    {
+        throw std::runtime_error("Task allocation test failed: steady-state submission allocated " +
+                                 std::to_string(after - before) + " times");
+    }
+}
+
+int main()
+{
+    std::cout << "Running Xeno Allocation Tests..." << std::endl;
+
+    try
+    {
+        test_task_submission_allocations();
+        std::cout << "✓ Task submission allocation test passed" << std::endl;
+
+        std::cout << "All tests passed!" << std::endl;
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
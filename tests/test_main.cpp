@@ -4,6 +4,35 @@
 // Forward declarations of test functions
 void test_engine_creation();
 void test_engine_singleton();
+void test_arena_alignment();
+void test_arena_markers();
+void test_arena_virtual();
+void test_frame_arenas();
+void test_pool_alloc_free();
+void test_size_class_pool();
+void test_pmr_resources();
+void test_memory_tags();
+void test_threadpool_scratch();
+void test_threadpool_work_stealing();
+void test_threadpool_task_handles();
+void test_threadpool_priorities();
+void test_threadpool_idle();
+void test_threadpool_stats();
+void test_cpu_topology();
+void test_threadpool_task_group();
+void test_parallel_algorithms();
+void test_task_graph();
+void test_inline_task();
+void test_spsc_queue();
+void test_mpmc_queue();
+void test_coroutine_tasks();
+void test_fiber_jobs();
+void test_logger_async();
+void test_logger_binary();
+void test_logger_filtering();
+void test_logger_ordering();
+void test_logger_mapped();
+void test_logger_limited();
 
 int main()
 {
@@ -17,6 +46,93 @@ int main()
         test_engine_singleton();
         std::cout << "✓ Engine singleton test passed" << std::endl;
 
+        test_arena_alignment();
+        std::cout << "✓ Arena alignment test passed" << std::endl;
+
+        test_arena_markers();
+        std::cout << "✓ Arena marker test passed" << std::endl;
+
+        test_arena_virtual();
+        std::cout << "✓ Virtual arena test passed" << std::endl;
+
+        test_frame_arenas();
+        std::cout << "✓ Frame arena test passed" << std::endl;
+
+        test_pool_alloc_free();
+        std::cout << "✓ Pool alloc/free test passed" << std::endl;
+
+        test_size_class_pool();
+        std::cout << "✓ Size class pool test passed" << std::endl;
+
+        test_pmr_resources();
+        std::cout << "✓ pmr resource test passed" << std::endl;
+
+        test_memory_tags();
+        std::cout << "✓ Memory tag test passed" << std::endl;
+
+        test_threadpool_scratch();
+        std::cout << "✓ ThreadPool scratch arena test passed" << std::endl;
+
+        test_threadpool_work_stealing();
+        std::cout << "✓ ThreadPool work stealing test passed" << std::endl;
+
+        test_threadpool_task_handles();
+        std::cout << "✓ ThreadPool task handle test passed" << std::endl;
+
+        test_threadpool_priorities();
+        std::cout << "✓ ThreadPool priority test passed" << std::endl;
+
+        test_threadpool_idle();
+        std::cout << "✓ ThreadPool idle policy test passed" << std::endl;
+
+        test_threadpool_stats();
+        std::cout << "✓ ThreadPool stats test passed" << std::endl;
+
+        test_cpu_topology();
+        std::cout << "✓ CPU topology test passed" << std::endl;
+
+        test_threadpool_task_group();
+        std::cout << "✓ ThreadPool task group test passed" << std::endl;
+
+        test_parallel_algorithms();
+        std::cout << "✓ Parallel algorithm test passed" << std::endl;
+
+        test_task_graph();
+        std::cout << "✓ Task graph test passed" << std::endl;
+
+        test_inline_task();
+        std::cout << "✓ Inline task test passed" << std::endl;
+
+        test_spsc_queue();
+        std::cout << "✓ SPSC queue test passed" << std::endl;
+
+        test_mpmc_queue();
+        std::cout << "✓ MPMC queue test passed" << std::endl;
+
+        test_coroutine_tasks();
+        std::cout << "✓ Coroutine task test passed" << std::endl;
+
+        test_fiber_jobs();
+        std::cout << "✓ Fiber job test passed" << std::endl;
+
+        test_logger_async();
+        std::cout << "✓ Async logger test passed" << std::endl;
+
+        test_logger_binary();
+        std::cout << "✓ Binary logger test passed" << std::endl;
+
+        test_logger_filtering();
+        std::cout << "✓ Logger filtering test passed" << std::endl;
+
+        test_logger_ordering();
+        std::cout << "✓ Logger ordering test passed" << std::endl;
+
+        test_logger_mapped();
+        std::cout << "✓ Mapped logger test passed" << std::endl;
+
+        test_logger_limited();
+        std::cout << "✓ Limited logger test passed" << std::endl;
+
         std::cout << "All tests passed!" << std::endl;
         return 0;
     }
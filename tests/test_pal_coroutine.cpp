@@ -0,0 +1,153 @@
+#include "xeno-pal/xeno-pal-coroutine.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+    xeno::Task<int> answerPart()
+    {
+        co_return 20;
+    }
+
+    xeno::Task<int> chained(xeno::pal::ThreadPool &pool, std::thread::id caller, bool &movedOff)
+    {
+        co_await xeno::pal::resumeOn(pool);
+        movedOff = std::this_thread::get_id() != caller;
+        int part = co_await answerPart();
+        co_return part + 22;
+    }
+
+    xeno::Task<> failing(xeno::pal::ThreadPool &pool)
+    {
+        co_await xeno::pal::resumeOn(pool);
+        throw std::logic_error("expected");
+    }
+
+    xeno::Task<> frameHop(xeno::pal::MainThreadQueue &queue, std::thread::id &resumedOn, std::atomic<bool> &done)
+    {
+        co_await xeno::pal::nextFrame(queue);
+        resumedOn = std::this_thread::get_id();
+        done = true;
+    }
+
+    xeno::Task<size_t> loadFile(xeno::pal::ThreadPool &pool, std::string path)
+    {
+        std::vector<char> data = co_await xeno::pal::readFileAsync(pool, path);
+        co_return data.size();
+    }
+
+    xeno::Task<> pollUntil(xeno::pal::MainThreadQueue &queue, bool &started, int &frame, int readyAt, int &resumedAt)
+    {
+        co_await xeno::pal::nextFrame(queue);
+        started = true;
+        co_await xeno::pal::waitUntil(queue, [&frame, readyAt]()
+                                      { return frame >= readyAt; });
+        resumedAt = frame;
+    }
+}
+
+void test_coroutine_tasks()
+{
+    xeno::pal::ThreadPoolConfig config;
+    config.workerThreads = 2;
+    config.ioThreads = 1;
+    xeno::pal::ThreadPool pool(config);
+
+    bool movedOff = false;
+    xeno::pal::TaskHandle<int> answer = xeno::pal::spawn(pool, chained(pool, std::this_thread::get_id(), movedOff));
+    // Not get(): a helping wait could resume the coroutine on this thread
+    while (!answer.isReady())
+    {
+        std::this_thread::yield();
+    }
+    if (answer.get() != 42)
+    {
+        throw std::runtime_error("Coroutine test failed: wrong result from chained tasks");
+    }
+    if (!movedOff)
+    {
+        throw std::runtime_error("Coroutine test failed: resumeOn did not move to a worker");
+    }
+
+    bool rethrown = false;
+    try
+    {
+        xeno::pal::spawn(pool, failing(pool)).get();
+    }
+    catch (const std::logic_error &)
+    {
+        rethrown = true;
+    }
+    if (!rethrown)
+    {
+        throw std::runtime_error("Coroutine test failed: exception not propagated");
+    }
+
+    // Resumes on whichever thread drains the queue, and only on the next drain
+    xeno::pal::MainThreadQueue queue;
+    std::thread::id resumedOn;
+    std::atomic<bool> done{false};
+    xeno::pal::TaskHandle<void> hop = xeno::pal::spawn(pool, frameHop(queue, resumedOn, done));
+    while (!done)
+    {
+        queue.runPending();
+        std::this_thread::yield();
+    }
+    hop.wait();
+    if (resumedOn != std::this_thread::get_id())
+    {
+        throw std::runtime_error("Coroutine test failed: nextFrame did not resume on the main thread");
+    }
+
+    const char *path = "xeno_coroutine_test.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        std::string contents(4096, 'x');
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+    size_t size = xeno::pal::spawn(pool, loadFile(pool, path)).get();
+    std::remove(path);
+    if (size != 4096)
+    {
+        throw std::runtime_error("Coroutine test failed: async file read returned wrong size");
+    }
+
+    bool missingThrew = false;
+    try
+    {
+        xeno::pal::spawn(pool, loadFile(pool, "xeno_missing_file.bin")).get();
+    }
+    catch (const std::runtime_error &)
+    {
+        missingThrew = true;
+    }
+    if (!missingThrew)
+    {
+        throw std::runtime_error("Coroutine test failed: missing file did not throw");
+    }
+
+    // Polled once per frame, continuing the first frame the condition holds.
+    // Frames are only counted once the coroutine has reached the main thread.
+    bool started = false;
+    int frame = 0;
+    int resumedAt = -1;
+    xeno::pal::TaskHandle<void> polled = xeno::pal::spawn(pool, pollUntil(queue, started, frame, 3, resumedAt));
+    for (int spins = 0; resumedAt < 0 && spins < 1000000; ++spins)
+    {
+        queue.runPending();
+        if (started)
+        {
+            ++frame;
+        }
+        std::this_thread::yield();
+    }
+    polled.wait();
+    if (resumedAt != 3)
+    {
+        throw std::runtime_error("Coroutine test failed: waitUntil resumed on frame " + std::to_string(resumedAt));
+    }
+}
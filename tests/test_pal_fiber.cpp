@@ -0,0 +1,94 @@
+#include "xeno-pal/xeno-pal-fiber.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+    // Quadtree-style refinement: every node forks four children and waits
+    void refine(xeno::pal::FiberJobSystem &jobs, int depth, std::atomic<int> &leaves)
+    {
+        if (depth == 0)
+        {
+            leaves.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        xeno::pal::JobCounter children;
+        for (int i = 0; i < 4; ++i)
+        {
+            jobs.run([&jobs, depth, &leaves]()
+                     { refine(jobs, depth - 1, leaves); },
+                     &children);
+        }
+        jobs.waitFor(children);
+    }
+
+    // A single chain of nested waits, one fiber per level
+    void chain(xeno::pal::FiberJobSystem &jobs, int depth, std::atomic<int> &reached)
+    {
+        reached.fetch_add(1, std::memory_order_relaxed);
+        if (depth == 0)
+        {
+            return;
+        }
+        xeno::pal::JobCounter child;
+        jobs.run([&jobs, depth, &reached]()
+                 { chain(jobs, depth - 1, reached); },
+                 &child);
+        jobs.waitFor(child);
+    }
+}
+
+void test_fiber_jobs()
+{
+    xeno::pal::FiberJobSystemConfig config;
+    config.workerThreads = 2;
+    config.initialFibers = 4;
+    xeno::pal::FiberJobSystem jobs(config);
+
+    std::atomic<int> leaves{0};
+    xeno::pal::JobCounter root;
+    jobs.run([&jobs, &leaves]()
+             { refine(jobs, 6, leaves); },
+             &root);
+    jobs.waitFor(root);
+    if (leaves != 4096)
+    {
+        throw std::runtime_error("Fiber test failed: expected 4096 leaves, got " + std::to_string(leaves.load()));
+    }
+
+    // Deeper than the initial pool: parked fibers force more to be created
+    std::atomic<int> reached{0};
+    xeno::pal::JobCounter chained;
+    jobs.run([&jobs, &reached]()
+             { chain(jobs, 200, reached); },
+             &chained);
+    jobs.waitFor(chained);
+    if (reached != 201 || jobs.fiberCount() < 200)
+    {
+        throw std::runtime_error("Fiber test failed: nested waits did not each get a fiber");
+    }
+
+    // A parked fiber is resumed once a slow job finishes
+    std::atomic<bool> slowDone{false};
+    std::atomic<bool> sawSlow{false};
+    xeno::pal::JobCounter outer;
+    jobs.run([&]()
+             {
+        xeno::pal::JobCounter slow;
+        jobs.run([&slowDone]()
+                 {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            slowDone = true; },
+                 &slow);
+        jobs.waitFor(slow);
+        sawSlow = slowDone.load(); },
+             &outer);
+    jobs.waitFor(outer);
+    if (!sawSlow)
+    {
+        throw std::runtime_error("Fiber test failed: waiter resumed before its counter reached zero");
+    }
+}
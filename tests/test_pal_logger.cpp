@@ -0,0 +1,572 @@
+// Trace statements in this file are compiled out; see test_logger_filtering
+#define XENO_LOG_MIN_LEVEL 1 // XENO_LOG_LEVEL_DEBUG
+#include "xeno-pal/xeno-pal.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector<std::string> readLines(const char *path)
+    {
+        std::vector<std::string> lines;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);)
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+}
+
+void test_logger_async()
+{
+    const char *path = "xeno_logger_test.log";
+    std::remove(path);
+
+    // Block: nothing is lost, and flush() makes every line visible
+    constexpr int Threads = 4;
+    constexpr int PerThread = 2000;
+    {
+        xeno::pal::LoggerConfig config;
+        config.capacity = 64;
+        config.overflow = xeno::pal::LogOverflow::Block;
+        xeno::pal::Logger logger(path, config);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < Threads; ++t)
+        {
+            threads.emplace_back([&logger, t]()
+                                 {
+                for (int i = 0; i < PerThread; ++i)
+                {
+                    logger.logWarning("thread " + std::to_string(t) + " message " + std::to_string(i));
+                } });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        logger.logError(std::string(1000, 'x'));
+        logger.flush();
+
+        std::vector<std::string> lines = readLines(path);
+        if (lines.size() != Threads * PerThread + 1)
+        {
+            throw std::runtime_error("Logger test failed: flush() returned before every record was written");
+        }
+        if (lines.front().find(" [Warning] thread ") == std::string::npos)
+        {
+            throw std::runtime_error("Logger test failed: unexpected line format: " + lines.front());
+        }
+        if (lines.back().find(" [Error] ") == std::string::npos ||
+            lines.back().size() - lines.back().find("] ") - 2 != xeno::pal::Logger::MaxMessageLength)
+        {
+            throw std::runtime_error("Logger test failed: long message was not truncated");
+        }
+    }
+    std::remove(path);
+
+    // CountDropped: every record is either written or counted, and a count
+    // above zero leaves a note in the file
+    constexpr int Burst = 20000;
+    {
+        xeno::pal::LoggerConfig config;
+        config.capacity = 4;
+        config.overflow = xeno::pal::LogOverflow::CountDropped;
+        xeno::pal::Logger logger(path, config);
+        for (int i = 0; i < Burst; ++i)
+        {
+            logger.logInfo("burst");
+        }
+        logger.flush();
+
+        std::vector<std::string> lines = readLines(path);
+        uint64_t written = 0;
+        bool noted = false;
+        for (const std::string &line : lines)
+        {
+            written += line.find("[Info] burst") != std::string::npos ? 1 : 0;
+            noted = noted || line.find("log records dropped") != std::string::npos;
+        }
+        if (written + logger.droppedCount() != Burst)
+        {
+            throw std::runtime_error("Logger test failed: records were neither written nor counted as dropped");
+        }
+        if (logger.droppedCount() > 0 && !noted)
+        {
+            throw std::runtime_error("Logger test failed: dropped records were not reported in the log");
+        }
+    }
+    std::remove(path);
+}
+
+namespace
+{
+    enum class AssetKind
+    {
+        Mesh = 3
+    };
+
+    xeno::pal::LogCategory assetLog{"Assets"};
+
+    void logStructured(xeno::pal::Logger &logger)
+    {
+        std::string name = "terrain";
+        XENO_LOG_INFO(logger, assetLog, "loaded {} meshes in {} ms", 12, 3.5);
+        XENO_LOG_WARNING(logger, assetLog, "asset {} kind {} missing={}", name, AssetKind::Mesh, true);
+        XENO_LOG_ERROR(logger, assetLog, "no arguments {}");
+        logger.logInfo("plain message");
+    }
+
+    // The message part of each line, after "[Level] "
+    std::vector<std::string> messages(const std::vector<std::string> &lines)
+    {
+        std::vector<std::string> result;
+        for (const std::string &line : lines)
+        {
+            size_t level = line.find(" [");
+            result.push_back(line.substr(level + 1));
+        }
+        return result;
+    }
+}
+
+void test_logger_binary()
+{
+    const std::vector<std::string> expected = {
+        "[Info] loaded 12 meshes in 3.5 ms",
+        "[Warning] asset terrain kind 3 missing=1",
+        "[Error] no arguments {}",
+        "[Info] plain message",
+    };
+
+    // Text encoding formats structured records on the writer thread
+    const char *textPath = "xeno_logger_test.log";
+    std::remove(textPath);
+    {
+        xeno::pal::Logger logger(textPath);
+        logStructured(logger);
+        logger.flush();
+    }
+    if (messages(readLines(textPath)) != expected)
+    {
+        throw std::runtime_error("Binary logger test failed: structured record formatted wrongly");
+    }
+
+    // Binary encoding decodes to the same lines. Two sessions check that the
+    // second one, appending to the file, redefines its format ids.
+    const char *binaryPath = "xeno_logger_test.binlog";
+    std::remove(binaryPath);
+    for (int session = 0; session < 2; ++session)
+    {
+        xeno::pal::LoggerConfig config;
+        config.encoding = xeno::pal::LogEncoding::Binary;
+        xeno::pal::Logger logger(binaryPath, config);
+        if (session == 1)
+        {
+            logger.logError("second session");
+        }
+        logStructured(logger);
+    }
+    std::ifstream binary(binaryPath, std::ios::binary);
+    std::stringstream decoded;
+    xeno::pal::binarylog::decode(binary, decoded);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(decoded, line);)
+    {
+        lines.push_back(line);
+    }
+    std::vector<std::string> twice = expected;
+    twice.push_back("[Error] second session");
+    twice.insert(twice.end(), expected.begin(), expected.end());
+    if (messages(lines) != twice)
+    {
+        throw std::runtime_error("Binary logger test failed: decoded log does not match the text log");
+    }
+    // "YYYY-MM-DD HH:MM:SS.mmm", as in text logs
+    if (lines.front().find(" [") != 23 || readLines(textPath).front().find(" [") != 23)
+    {
+        throw std::runtime_error("Binary logger test failed: decoded timestamp has the wrong format");
+    }
+
+    std::stringstream garbage("not a log");
+    bool rejected = false;
+    try
+    {
+        xeno::pal::binarylog::decode(garbage, decoded);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    std::remove(textPath);
+    std::remove(binaryPath);
+    if (!rejected)
+    {
+        throw std::runtime_error("Binary logger test failed: decoder accepted a file without the header");
+    }
+}
+
+void test_logger_filtering()
+{
+    const char *path = "xeno_logger_test.log";
+    std::remove(path);
+
+    xeno::pal::LogCategory category{"Filtering"};
+    int evaluated = 0;
+    {
+        xeno::pal::Logger logger(path);
+
+        // Below the compile-time minimum: the statement is gone, even when the
+        // category would let it through
+        category.setMinimumLevel(xeno::pal::LogLevel::Trace);
+        XENO_LOG_TRACE(logger, category, "trace {}", ++evaluated);
+
+        // Below the category's minimum: arguments are skipped at runtime
+        category.setMinimumLevel(xeno::pal::LogLevel::Warning);
+        XENO_LOG_DEBUG(logger, category, "debug {}", ++evaluated);
+        XENO_LOG_INFO(logger, category, "info {}", ++evaluated);
+        XENO_LOG_WARNING(logger, category, "warning {}", ++evaluated);
+
+        category.setMinimumLevel(xeno::pal::LogLevel::Debug);
+        XENO_LOG_DEBUG(logger, category, "debug {}", ++evaluated);
+        logger.flush();
+    }
+
+    std::vector<std::string> lines = readLines(path);
+    std::remove(path);
+    if (evaluated != 2)
+    {
+        throw std::runtime_error("Logger filtering test failed: filtered statement evaluated its arguments");
+    }
+    if (lines.size() != 2 || lines[0].find("[Warning] warning 1") == std::string::npos ||
+        lines[1].find("[Debug] debug 2") == std::string::npos)
+    {
+        throw std::runtime_error("Logger filtering test failed: wrong statements reached the log");
+    }
+    if (category.minimumLevel() != xeno::pal::LogLevel::Debug || std::string(category.name()) != "Filtering")
+    {
+        throw std::runtime_error("Logger filtering test failed: category state not kept");
+    }
+}
+
+void test_logger_ordering()
+{
+    const char *path = "xeno_logger_ordering.log";
+    std::remove(path);
+
+    // Threads take turns through a shared counter, so each step happens
+    // after the previous one; the merged file must list them in that order
+    // even though every thread writes to its own ring
+    constexpr int Threads = 3;
+    constexpr int Steps = 3000;
+    {
+        xeno::pal::Logger logger(path);
+        std::atomic<int> turn{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < Threads; ++t)
+        {
+            threads.emplace_back([&logger, &turn, t]()
+                                 {
+                for (int step = t; step < Steps; step += Threads)
+                {
+                    while (turn.load(std::memory_order_acquire) != step)
+                    {
+                        std::this_thread::yield();
+                    }
+                    logger.logInfo("step " + std::to_string(step));
+                    turn.store(step + 1, std::memory_order_release);
+                } });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        // The workers have exited; their rings are drained before being freed
+        logger.logInfo("done");
+        logger.flush();
+
+        std::vector<std::string> lines = readLines(path);
+        if (lines.size() != Steps + 1)
+        {
+            throw std::runtime_error("Logger ordering test failed: expected " + std::to_string(Steps + 1) +
+                                     " lines, got " + std::to_string(lines.size()));
+        }
+        for (int step = 0; step < Steps; ++step)
+        {
+            if (lines[step].find("[Info] step " + std::to_string(step)) == std::string::npos ||
+                lines[step].size() != lines[step].find("step ") + 5 + std::to_string(step).size())
+            {
+                throw std::runtime_error("Logger ordering test failed: line " + std::to_string(step) +
+                                         " is out of order: " + lines[step]);
+            }
+        }
+        if (lines.back().find("[Info] done") == std::string::npos)
+        {
+            throw std::runtime_error("Logger ordering test failed: last line is " + lines.back());
+        }
+    }
+    std::remove(path);
+}
+
+namespace
+{
+    std::string readBytes(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // The log text of a LogSink::Mapped file, checking its header
+    std::string mappedLog(const std::string &path)
+    {
+        std::string bytes = readBytes(path);
+        xeno::pal::MappedLogHeader header;
+        if (bytes.size() < sizeof(header))
+        {
+            throw std::runtime_error("Mapped logger test failed: " + path + " has no header");
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, xeno::pal::MappedLogHeader::Magic, sizeof(header.magic)) != 0 ||
+            header.committed > bytes.size() - sizeof(header))
+        {
+            throw std::runtime_error("Mapped logger test failed: " + path + " has a bad header");
+        }
+        return bytes.substr(sizeof(header), header.committed);
+    }
+
+    void removeRotated(const std::string &path, int count)
+    {
+        std::remove(path.c_str());
+        for (int i = 1; i <= count; ++i)
+        {
+            std::remove((path + "." + std::to_string(i)).c_str());
+        }
+    }
+}
+
+void test_logger_mapped()
+{
+    const std::string path = "xeno_logger_mapped.log";
+    constexpr size_t RotateBytes = 64 * 1024;
+    removeRotated(path, 3);
+
+    xeno::pal::LoggerConfig config;
+    config.sink = xeno::pal::LogSink::Mapped;
+    config.rotateBytes = RotateBytes;
+    config.keepFiles = 2;
+    config.overflow = xeno::pal::LogOverflow::Block;
+
+    // Each line is about 36 bytes, so this spans five files and the two
+    // oldest are deleted
+    constexpr int Lines = 8000;
+    {
+        xeno::pal::Logger logger(path, config);
+        logger.logInfo("first");
+        logger.flush();
+
+        // While open the file keeps its full size, and the committed length
+        // covers exactly the lines written so far
+        if (readBytes(path).size() != RotateBytes || mappedLog(path).find("[Info] first\n") == std::string::npos)
+        {
+            throw std::runtime_error("Mapped logger test failed: open file is not pre-sized with a committed line");
+        }
+        for (int i = 0; i < Lines; ++i)
+        {
+            logger.logInfo("line " + std::to_string(i));
+        }
+    }
+
+    std::string newest = mappedLog(path);
+    std::string rotated = mappedLog(path + ".2") + mappedLog(path + ".1") + newest;
+    if (std::ifstream(path + ".3") || readBytes(path).size() != sizeof(xeno::pal::MappedLogHeader) + newest.size())
+    {
+        throw std::runtime_error("Mapped logger test failed: old files were kept or the closed file was not trimmed");
+    }
+    std::istringstream lines(rotated);
+    std::string line;
+    int expected = -1;
+    for (int count = 0; std::getline(lines, line); ++count)
+    {
+        int number = std::stoi(line.substr(line.find("[Info] line ") + 12));
+        if (count > 0 && number != expected)
+        {
+            throw std::runtime_error("Mapped logger test failed: rotated files are not contiguous at " + line);
+        }
+        expected = number + 1;
+    }
+    if (expected != Lines)
+    {
+        throw std::runtime_error("Mapped logger test failed: the last line is missing");
+    }
+
+    // Reopening appends to the newest file
+    {
+        xeno::pal::Logger logger(path, config);
+        logger.logInfo("reopened");
+    }
+    std::string appended = mappedLog(path);
+    if (appended.compare(0, newest.size(), newest) != 0 ||
+        appended.find(" [Info] reopened\n") != newest.size() + 23)
+    {
+        throw std::runtime_error("Mapped logger test failed: reopening did not append after the committed bytes");
+    }
+    removeRotated(path, 2);
+
+    // Binary logs decode straight from the mapped file
+    config.encoding = xeno::pal::LogEncoding::Binary;
+    {
+        xeno::pal::Logger logger(path, config);
+        logger.logWarning("mapped binary");
+    }
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream decoded;
+    xeno::pal::binarylog::decode(in, decoded);
+    if (decoded.str().find("[Warning] mapped binary\n") == std::string::npos)
+    {
+        throw std::runtime_error("Mapped logger test failed: binary log did not decode: " + decoded.str());
+    }
+
+    // A header claiming more log than the file holds is rejected up front
+    xeno::pal::MappedLogHeader corrupt{};
+    std::memcpy(corrupt.magic, xeno::pal::MappedLogHeader::Magic, sizeof(corrupt.magic));
+    corrupt.committed = uint64_t(1) << 60;
+    corrupt.capacity = RotateBytes;
+    std::istringstream truncated(std::string(reinterpret_cast<const char *>(&corrupt), sizeof(corrupt)) + "[Info] x\n");
+    bool rejected = false;
+    try
+    {
+        std::ostringstream ignored;
+        xeno::pal::binarylog::decode(truncated, ignored);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    if (!rejected)
+    {
+        throw std::runtime_error("Mapped logger test failed: corrupt committed length was accepted");
+    }
+    removeRotated(path, 2);
+
+    // The stdio sink rotates the same way
+    config = {};
+    config.rotateBytes = RotateBytes;
+    config.keepFiles = 1;
+    config.overflow = xeno::pal::LogOverflow::Block;
+    {
+        xeno::pal::Logger logger(path, config);
+        for (int i = 0; i < Lines; ++i)
+        {
+            logger.logInfo("line " + std::to_string(i));
+        }
+    }
+    if (readBytes(path).size() > RotateBytes || readBytes(path + ".1").size() > RotateBytes ||
+        readBytes(path + ".1").empty() || std::ifstream(path + ".2"))
+    {
+        throw std::runtime_error("Mapped logger test failed: the stdio sink did not rotate");
+    }
+    removeRotated(path, 1);
+
+    // By default a File sink never rotates, and a Mapped sink uses 64 MiB files
+    config = {};
+    config.overflow = xeno::pal::LogOverflow::Block;
+    {
+        xeno::pal::Logger logger(path, config);
+        for (int i = 0; i < Lines; ++i)
+        {
+            logger.logInfo("line " + std::to_string(i));
+        }
+    }
+    if (readBytes(path).size() <= RotateBytes || std::ifstream(path + ".1"))
+    {
+        throw std::runtime_error("Mapped logger test failed: the stdio sink rotated unasked");
+    }
+    std::remove(path.c_str());
+    config.sink = xeno::pal::LogSink::Mapped;
+    {
+        xeno::pal::Logger logger(path, config);
+        logger.logInfo("default size");
+        logger.flush();
+        std::ifstream mapped(path, std::ios::binary | std::ios::ate);
+        if (static_cast<size_t>(mapped.tellg()) != 64 * 1024 * 1024)
+        {
+            throw std::runtime_error("Mapped logger test failed: default mapped file size is wrong");
+        }
+    }
+    removeRotated(path, 1);
+}
+
+namespace
+{
+    xeno::pal::LogCategory hotLoopLog{"HotLoop"};
+}
+
+void test_logger_limited()
+{
+    const char *path = "xeno_logger_limited.log";
+    std::remove(path);
+
+    // A burst well past the budget, then one more call after the window has
+    // rolled over, which should report what was held back
+    constexpr int Burst = 10000;
+    constexpr uint32_t PerSecond = 5;
+    int evaluated = 0;
+    auto count = [&evaluated](int value)
+    {
+        ++evaluated;
+        return value;
+    };
+    {
+        xeno::pal::Logger logger(path);
+        auto hotLoop = [&](int i)
+        {
+            XENO_LOG_LIMITED(logger, hotLoopLog, xeno::pal::LogLevel::Error, PerSecond, "bad result {}", count(i));
+        };
+        for (int i = 0; i < Burst; ++i)
+        {
+            hotLoop(i);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        hotLoop(Burst);
+        logger.flush();
+    }
+
+    std::vector<std::string> lines = readLines(path);
+    std::remove(path);
+    uint64_t written = 0;
+    uint64_t repeated = 0;
+    for (const std::string &line : lines)
+    {
+        size_t note = line.find("[Error] last message repeated ");
+        if (note != std::string::npos)
+        {
+            repeated += std::stoull(line.substr(note + 30));
+            if (line.find(" times: bad result {}") == std::string::npos)
+            {
+                throw std::runtime_error("Limited logger test failed: unexpected repeat note: " + line);
+            }
+            continue;
+        }
+        written += line.find("[Error] bad result ") != std::string::npos ? 1 : 0;
+    }
+    if (written + repeated != Burst + 1 || written < PerSecond + 1 || static_cast<uint64_t>(evaluated) != written)
+    {
+        throw std::runtime_error("Limited logger test failed: " + std::to_string(written) + " written, " +
+                                 std::to_string(repeated) + " repeated, " + std::to_string(evaluated) + " evaluated");
+    }
+    if (lines.size() < 2 || lines.back().find("bad result " + std::to_string(Burst)) == std::string::npos ||
+        lines[lines.size() - 2].find("last message repeated") == std::string::npos)
+    {
+        throw std::runtime_error("Limited logger test failed: the held-back count was not reported before the next record");
+    }
+}
@@ -0,0 +1,351 @@
+#include "xeno-pal/xeno-pal.hpp"
+#include "xeno-pal/xeno-pal-pmr.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_arena_alignment()
+{
+    xeno::pal::Arena arena(1024);
+
+    // Knock the offset off any natural boundary first
+    arena.allocate(3, 1);
+
+    void *p16 = arena.allocate(16, 16);
+    if (reinterpret_cast<uintptr_t>(p16) % 16 != 0)
+    {
+        throw std::runtime_error("Arena alignment test failed: 16-byte request misaligned");
+    }
+
+    void *p64 = arena.allocate(8, 64);
+    if (reinterpret_cast<uintptr_t>(p64) % 64 != 0)
+    {
+        throw std::runtime_error("Arena alignment test failed: 64-byte request misaligned");
+    }
+
+    double *values = arena.alloc<double>(4);
+    if (reinterpret_cast<uintptr_t>(values) % alignof(double) != 0)
+    {
+        throw std::runtime_error("Arena alignment test failed: alloc<T> ignores alignof(T)");
+    }
+}
+
+void test_arena_markers()
+{
+    xeno::pal::Arena arena(1024);
+    arena.allocate(100);
+    xeno::pal::Arena::Marker marker = arena.mark();
+
+    {
+        xeno::pal::ArenaScope scope(arena);
+        arena.allocate(500);
+        if (arena.used() < 600)
+        {
+            throw std::runtime_error("Arena marker test failed: used() did not grow");
+        }
+    }
+
+    if (arena.used() != marker.offset)
+    {
+        throw std::runtime_error("Arena marker test failed: ArenaScope did not roll back");
+    }
+    if (arena.highWaterMark() < 600)
+    {
+        throw std::runtime_error("Arena marker test failed: high water mark was lost on rollback");
+    }
+
+    // Resetting inside a scope leaves the arena reset instead of throwing
+    // from the scope's destructor
+    {
+        xeno::pal::ArenaScope scope(arena);
+        arena.allocate(200);
+        arena.reset();
+        arena.allocate(50);
+    }
+    if (arena.used() != 50)
+    {
+        throw std::runtime_error("Arena marker test failed: ArenaScope after reset() moved the offset");
+    }
+
+    arena.reset();
+    if (arena.used() != 0 || arena.highWaterMark() < 600)
+    {
+        throw std::runtime_error("Arena marker test failed: reset() state incorrect");
+    }
+
+    bool threw = false;
+    try
+    {
+        arena.allocate(2048);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    if (!threw)
+    {
+        throw std::runtime_error("Arena marker test failed: exhaustion did not throw");
+    }
+}
+
+void test_arena_virtual()
+{
+    xeno::pal::Arena::VirtualConfig config;
+    config.reserveSize = 256 * 1024 * 1024;
+    config.commitChunk = 64 * 1024;
+    config.retainOnReset = 128 * 1024;
+    xeno::pal::Arena arena(config);
+
+    if (!arena.isVirtual() || arena.committed() != 0)
+    {
+        throw std::runtime_error("Virtual arena test failed: memory committed before first use");
+    }
+
+    char *small = arena.alloc<char>(100);
+    small[99] = 1;
+    if (arena.committed() != 64 * 1024)
+    {
+        throw std::runtime_error("Virtual arena test failed: first allocation did not commit one chunk");
+    }
+
+    char *big = arena.alloc<char>(8 * 1024 * 1024);
+    big[8 * 1024 * 1024 - 1] = 1;
+    if (arena.committed() < 8 * 1024 * 1024 || arena.committed() > 9 * 1024 * 1024)
+    {
+        throw std::runtime_error("Virtual arena test failed: commit did not track demand");
+    }
+
+    arena.reset();
+    if (arena.committed() != 128 * 1024)
+    {
+        throw std::runtime_error("Virtual arena test failed: reset() did not decommit past threshold");
+    }
+
+    // Memory is usable again after decommit
+    char *again = arena.alloc<char>(1024 * 1024);
+    again[1024 * 1024 - 1] = 2;
+
+    // Leaving reserveSize unset is reported as such
+    bool threw = false;
+    try
+    {
+        xeno::pal::Arena::VirtualConfig unsized;
+        unsized.commitChunk = 64 * 1024;
+        xeno::pal::Arena empty(unsized);
+    }
+    catch (const std::runtime_error &error)
+    {
+        threw = std::string(error.what()).find("reserveSize") != std::string::npos;
+    }
+    if (!threw)
+    {
+        throw std::runtime_error("Virtual arena test failed: zero reserveSize not rejected");
+    }
+}
+
+void test_frame_arenas()
+{
+    xeno::pal::Arena::VirtualConfig config;
+    config.reserveSize = 16 * 1024 * 1024;
+    xeno::pal::FrameArenas frames(2, config);
+
+    frames.beginFrame(0);
+    frames.current().allocate(1000);
+    frames.beginFrame(1);
+    frames.current().allocate(2000);
+
+    // Frame 0 is still in flight while frame 1 records
+    if (frames.frame(0).used() < 1000)
+    {
+        throw std::runtime_error("Frame arena test failed: in-flight frame was reset early");
+    }
+
+    frames.beginFrame(0);
+    if (frames.current().used() != 0 || frames.frame(1).used() < 2000)
+    {
+        throw std::runtime_error("Frame arena test failed: wrong arena recycled");
+    }
+}
+
+namespace
+{
+    struct PooledEntity
+    {
+        static int alive;
+        alignas(32) float transform[8];
+        int id;
+        explicit PooledEntity(int entityId) : id(entityId) { ++alive; }
+        ~PooledEntity() { --alive; }
+    };
+    int PooledEntity::alive = 0;
+}
+
+void test_pool_alloc_free()
+{
+    xeno::pal::Pool<PooledEntity> pool(16);
+    std::vector<PooledEntity *> entities;
+    for (int i = 0; i < 40; ++i)
+    {
+        PooledEntity *entity = pool.create(i);
+        if (reinterpret_cast<uintptr_t>(entity) % alignof(PooledEntity) != 0)
+        {
+            throw std::runtime_error("Pool test failed: object misaligned");
+        }
+        entities.push_back(entity);
+    }
+
+    xeno::pal::PoolStats stats = pool.stats();
+    if (stats.live != 40 || stats.slabCount != 3 || stats.capacity != 48 || PooledEntity::alive != 40)
+    {
+        throw std::runtime_error("Pool test failed: unexpected occupancy after allocation");
+    }
+
+    // Freed blocks are reused before the pool grows again
+    PooledEntity *freed = entities[5];
+    pool.destroy(freed);
+    PooledEntity *reused = pool.create(99);
+    if (reused != freed || reused->id != 99)
+    {
+        throw std::runtime_error("Pool test failed: free list not reused");
+    }
+    entities[5] = reused;
+
+    for (PooledEntity *entity : entities)
+    {
+        pool.destroy(entity);
+    }
+    stats = pool.stats();
+    if (stats.live != 0 || stats.peakLive != 40 || stats.totalAllocations != 41 || PooledEntity::alive != 0)
+    {
+        throw std::runtime_error("Pool test failed: unexpected occupancy after release");
+    }
+}
+
+void test_size_class_pool()
+{
+    xeno::pal::SizeClassPool pool;
+    void *a = pool.allocate(10);
+    void *b = pool.allocate(100);
+    void *c = pool.allocate(4096);
+
+    auto stats = pool.stats();
+    if (stats[0].live != 1 || stats[3].live != 1 || stats[3].blockSize != 128 || pool.oversizedLive() != 1)
+    {
+        throw std::runtime_error("Size class pool test failed: wrong class selected");
+    }
+
+    pool.deallocate(a, 10);
+    pool.deallocate(b, 100);
+    pool.deallocate(c, 4096);
+    stats = pool.stats();
+    if (stats[0].live != 0 || stats[3].live != 0 || pool.oversizedLive() != 0)
+    {
+        throw std::runtime_error("Size class pool test failed: blocks not returned");
+    }
+}
+
+void test_pmr_resources()
+{
+    xeno::pal::Arena arena(64 * 1024);
+    xeno::pal::ArenaResource arenaResource(arena);
+    {
+        std::pmr::vector<uint32_t> indices(&arenaResource);
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            indices.push_back(i);
+        }
+        if (arena.used() < 1000 * sizeof(uint32_t) || indices[999] != 999)
+        {
+            throw std::runtime_error("pmr test failed: vector did not allocate from the arena");
+        }
+    }
+
+    xeno::pal::SizeClassPool pool;
+    xeno::pal::PoolResource poolResource(pool);
+    {
+        std::pmr::vector<double> values(16, 1.0, &poolResource);
+        if (pool.stats()[3].live != 1)
+        {
+            throw std::runtime_error("pmr test failed: vector did not allocate from the pool");
+        }
+    }
+    if (pool.stats()[3].live != 0)
+    {
+        throw std::runtime_error("pmr test failed: vector did not return its block");
+    }
+
+    // Too big for any size class, and aligned past what plain new promises
+    for (size_t alignment : {size_t(32), size_t(64)})
+    {
+        std::vector<void *> blocks;
+        for (int i = 0; i < 32; ++i)
+        {
+            void *block = poolResource.allocate(4096 + 16 * i, alignment);
+            blocks.push_back(block);
+            if (reinterpret_cast<uintptr_t>(block) % alignment != 0)
+            {
+                throw std::runtime_error("pmr test failed: oversized block is not " + std::to_string(alignment) + "-byte aligned");
+            }
+        }
+        for (int i = 0; i < 32; ++i)
+        {
+            poolResource.deallocate(blocks[i], 4096 + 16 * i, alignment);
+        }
+    }
+
+    if (arenaResource.is_equal(poolResource) || !arenaResource.is_equal(arenaResource))
+    {
+        throw std::runtime_error("pmr test failed: is_equal identity broken");
+    }
+}
+
+void test_memory_tags()
+{
+    using xeno::pal::MemoryTag;
+    namespace memory = xeno::pal::memory;
+
+    int64_t baseline = memory::stats(MemoryTag::Terrain).currentBytes;
+    {
+        xeno::pal::Arena arena(4096, MemoryTag::Terrain);
+        xeno::pal::Pool<double> pool(128, MemoryTag::Terrain);
+        pool.destroy(pool.create(1.0));
+        if (memory::stats(MemoryTag::Terrain).currentBytes != baseline + 4096 + static_cast<int64_t>(128 * sizeof(double)))
+        {
+            throw std::runtime_error("Memory tag test failed: allocators did not report");
+        }
+
+        // Counters recorded by a thread survive the thread exiting
+        std::thread worker([]()
+                           { memory::recordAllocation(MemoryTag::Terrain, 100); });
+        worker.join();
+        memory::recordFree(MemoryTag::Terrain, 100);
+
+        memory::setBudget(MemoryTag::Terrain, static_cast<size_t>(baseline) + 1024);
+        uint32_t exceeded = memory::sample();
+        if (!(exceeded & (1u << static_cast<uint32_t>(MemoryTag::Terrain))) || memory::sample() != 0)
+        {
+            throw std::runtime_error("Memory tag test failed: budget crossing not reported exactly once");
+        }
+    }
+
+    xeno::pal::MemoryTagStats stats = memory::stats(MemoryTag::Terrain);
+    memory::setBudget(MemoryTag::Terrain, 0);
+    memory::sample();
+    if (stats.currentBytes != baseline || stats.sampledPeakBytes < baseline + 4096 || stats.overBudget)
+    {
+        throw std::runtime_error("Memory tag test failed: current/peak incorrect after release");
+    }
+
+    // A thread's scratch arena is freed after its counters were first used,
+    // which puts the free after they are torn down at thread exit
+    int64_t scratchBaseline = memory::stats(MemoryTag::Scratch).currentBytes;
+    std::thread scratchUser([]()
+                            { xeno::pal::scratch().allocate(256 * 1024); });
+    scratchUser.join();
+    if (memory::stats(MemoryTag::Scratch).currentBytes != scratchBaseline)
+    {
+        throw std::runtime_error("Memory tag test failed: scratch memory freed at thread exit was not subtracted");
+    }
+}
@@ -0,0 +1,662 @@
+#include "xeno-pal/xeno-pal.hpp"
+#include "xeno-pal/xeno-pal-parallel.hpp"
+#include "xeno-pal/xeno-pal-taskgraph.hpp"
+#include "xeno-pal/xeno-pal-topology.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace
+{
+#if defined(__linux__)
+    // CPU time the calling thread has used, to check that waits park
+    double threadCpuMs()
+    {
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+    }
+#endif
+}
+
+void test_threadpool_scratch()
+{
+    std::atomic<int> dirtyStarts{0};
+    std::atomic<int> completed{0};
+    {
+        xeno::pal::ThreadPool pool(4);
+        for (int i = 0; i < 200; ++i)
+        {
+            pool.enqueue([&dirtyStarts, &completed, i]()
+                         {
+                xeno::pal::Arena &arena = xeno::pal::scratch();
+                if (arena.used() != 0)
+                {
+                    ++dirtyStarts;
+                }
+                int *values = arena.alloc<int>(1000 + i);
+                values[i] = i;
+                ++completed; });
+        }
+    }
+
+    if (completed != 200)
+    {
+        throw std::runtime_error("Scratch arena test failed: not every task ran");
+    }
+    if (dirtyStarts != 0)
+    {
+        throw std::runtime_error("Scratch arena test failed: scratch not rewound between tasks");
+    }
+    if (&xeno::pal::scratch() != &xeno::pal::scratch())
+    {
+        throw std::runtime_error("Scratch arena test failed: scratch() not stable per thread");
+    }
+}
+
+void test_threadpool_work_stealing()
+{
+    constexpr int Producers = 4;
+    constexpr int TasksPerProducer = 5000;
+    std::atomic<int> executed{0};
+    {
+        xeno::pal::ThreadPool pool(4);
+
+        // External submitters go through the injection queue, and every task
+        // fans out a child onto its worker's own deque for others to steal
+        std::vector<std::thread> producers;
+        for (int p = 0; p < Producers; ++p)
+        {
+            producers.emplace_back([&pool, &executed]()
+                                   {
+                for (int i = 0; i < TasksPerProducer; ++i)
+                {
+                    pool.enqueue([&pool, &executed]()
+                                 {
+                        ++executed;
+                        pool.enqueue([&executed]() { ++executed; }); });
+                } });
+        }
+        for (std::thread &producer : producers)
+        {
+            producer.join();
+        }
+    }
+
+    if (executed != Producers * TasksPerProducer * 2)
+    {
+        throw std::runtime_error("Work stealing test failed: tasks were lost or duplicated");
+    }
+}
+
+void test_threadpool_task_handles()
+{
+    xeno::pal::ThreadPool pool(2);
+
+    xeno::pal::TaskHandle<int> answer = pool.enqueue([]()
+                                                     { return 6 * 7; });
+    if (answer.get() != 42)
+    {
+        throw std::runtime_error("Task handle test failed: wrong result");
+    }
+
+    xeno::pal::TaskHandle<void> failing = pool.enqueue([]()
+                                                       { throw std::logic_error("expected"); });
+    bool rethrown = false;
+    try
+    {
+        failing.get();
+    }
+    catch (const std::logic_error &)
+    {
+        rethrown = true;
+    }
+    if (!rethrown)
+    {
+        throw std::runtime_error("Task handle test failed: exception not propagated");
+    }
+
+#if defined(__linux__)
+    // No worker can help with an I/O task, so waiting on a slow one has to
+    // park rather than spin
+    xeno::pal::ThreadPoolConfig config;
+    config.workerThreads = 1;
+    config.ioThreads = 1;
+    xeno::pal::ThreadPool ioPool(config);
+    xeno::pal::TaskHandle<void> slow = ioPool.enqueueIo([]()
+                                                        { std::this_thread::sleep_for(std::chrono::milliseconds(300)); });
+    double startMs = threadCpuMs();
+    slow.wait();
+    double cpuMs = threadCpuMs() - startMs;
+    if (cpuMs > 100.0)
+    {
+        throw std::runtime_error("Task handle test failed: waiting used " + std::to_string(cpuMs) + " ms of CPU");
+    }
+#endif
+}
+
+void test_threadpool_priorities()
+{
+    xeno::pal::ThreadPoolConfig config;
+    config.workerThreads = 2;
+    config.ioThreads = 1;
+    config.maxBackgroundWorkers = 1;
+    xeno::pal::ThreadPool pool(config);
+
+    // Two long background jobs, but only one may occupy a worker at a time
+    std::atomic<bool> release{false};
+    std::atomic<int> backgroundStarted{0};
+    std::vector<xeno::pal::TaskHandle<void>> background;
+    for (int i = 0; i < 2; ++i)
+    {
+        background.push_back(pool.enqueue(xeno::pal::TaskPriority::Background, [&]()
+                                          {
+            backgroundStarted.fetch_add(1);
+            while (!release.load())
+            {
+                std::this_thread::yield();
+            } }));
+    }
+    while (backgroundStarted.load() == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    std::atomic<int> frameExecuted{0};
+    {
+        xeno::pal::TaskGroup frame(pool, xeno::pal::TaskPriority::Frame);
+        for (int i = 0; i < 100; ++i)
+        {
+            frame.run([&frameExecuted]()
+                      { frameExecuted.fetch_add(1); });
+        }
+        frame.wait();
+    }
+    if (frameExecuted != 100)
+    {
+        throw std::runtime_error("Priority test failed: frame tasks did not run");
+    }
+    if (backgroundStarted != 1)
+    {
+        throw std::runtime_error("Priority test failed: background limit exceeded");
+    }
+
+    xeno::pal::TaskHandle<int> io = pool.enqueueIo([]()
+                                                   { return 7; });
+    if (io.get() != 7)
+    {
+        throw std::runtime_error("Priority test failed: I/O task did not run");
+    }
+
+    release = true;
+    for (xeno::pal::TaskHandle<void> &handle : background)
+    {
+        handle.wait();
+    }
+
+    // Background work waiting on background work reuses its slot instead of deadlocking
+    xeno::pal::TaskHandle<int> nested = pool.enqueue(xeno::pal::TaskPriority::Background, [&pool]()
+                                                     { return pool.enqueue(xeno::pal::TaskPriority::Background, []()
+                                                                           { return 3; })
+                                                           .get(); });
+    if (nested.get() != 3)
+    {
+        throw std::runtime_error("Priority test failed: nested background task");
+    }
+}
+
+namespace
+{
+    // Waits without helping, so only a worker can complete the task
+    bool runOnWorker(xeno::pal::ThreadPool &pool)
+    {
+        std::atomic<bool> done{false};
+        pool.dispatch([&done]()
+                      { done.store(true); });
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!done.load())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+}
+
+void test_threadpool_idle()
+{
+    // Parking immediately must never lose a wake-up
+    xeno::pal::ThreadPoolConfig parking;
+    parking.workerThreads = 2;
+    parking.idle.spinRounds = 0;
+    parking.idle.yieldRounds = 0;
+    {
+        xeno::pal::ThreadPool pool(parking);
+        for (int i = 0; i < 200; ++i)
+        {
+            if (!runOnWorker(pool))
+            {
+                throw std::runtime_error("Idle test failed: parked worker was never woken");
+            }
+        }
+        xeno::pal::IdleStats stats = pool.idleStats();
+        if (stats.spinHits != 0 || stats.parks == 0)
+        {
+            throw std::runtime_error("Idle test failed: parking policy still spun");
+        }
+    }
+
+    xeno::pal::ThreadPoolConfig spinning;
+    spinning.workerThreads = 1;
+    spinning.idle.spinRounds = 20;
+    spinning.idle.yieldRounds = 64;
+    xeno::pal::ThreadPool pool(spinning);
+    for (int i = 0; i < 100; ++i)
+    {
+        if (!runOnWorker(pool))
+        {
+            throw std::runtime_error("Idle test failed: spinning worker missed a task");
+        }
+    }
+    xeno::pal::IdleStats stats = pool.idleStats();
+    if (stats.spinHits == 0 || stats.spinNs == 0)
+    {
+        throw std::runtime_error("Idle test failed: spin phase never picked up work");
+    }
+}
+
+void test_threadpool_stats()
+{
+    xeno::pal::ThreadPool pool(2);
+    {
+        xeno::pal::TaskGroup group(pool);
+        for (int i = 0; i < 1000; ++i)
+        {
+            group.run([]()
+                      {
+                volatile int sink = 0;
+                for (int j = 0; j < 1000; ++j)
+                {
+                    sink = sink + j;
+                } });
+        }
+        group.wait();
+    }
+
+    xeno::pal::ThreadPoolStats stats = pool.stats();
+    uint64_t executed = stats.helpers.tasksExecuted;
+    for (const xeno::pal::WorkerStats &worker : stats.workers)
+    {
+        executed += worker.tasksExecuted;
+        if (worker.busyMs < 0.0 || worker.idleMs < 0.0)
+        {
+            throw std::runtime_error("ThreadPool stats test failed: negative busy or idle time");
+        }
+    }
+    if (stats.workers.size() != 2 || executed != 1000 || stats.execution.count != 1000 || stats.queueWait.count != 1000)
+    {
+        throw std::runtime_error("ThreadPool stats test failed: task counts do not add up");
+    }
+    const xeno::pal::LatencySummary &execution = stats.execution;
+    if (execution.p50Us <= 0.0 || execution.p50Us > execution.p99Us || execution.p99Us > execution.maxUs)
+    {
+        throw std::runtime_error("ThreadPool stats test failed: percentiles out of order");
+    }
+    if (stats.queueDepth != 0)
+    {
+        throw std::runtime_error("ThreadPool stats test failed: queue not drained");
+    }
+
+    xeno::pal::ThreadPoolConfig config;
+    config.workerThreads = 1;
+    config.instrumentation = false;
+    xeno::pal::ThreadPool quiet(config);
+    quiet.enqueue([]() {}).wait();
+    if (!quiet.stats().workers.empty())
+    {
+        throw std::runtime_error("ThreadPool stats test failed: instrumentation not disabled");
+    }
+}
+
+void test_cpu_topology()
+{
+    std::vector<uint32_t> parsed = xeno::pal::parseCpuList("0-3,8,10-11\n");
+    if (parsed != std::vector<uint32_t>{0, 1, 2, 3, 8, 10, 11})
+    {
+        throw std::runtime_error("CPU topology test failed: CPU list parsed incorrectly");
+    }
+
+    const xeno::pal::CpuTopology &topology = xeno::pal::CpuTopology::get();
+    if (topology.cpus.empty() || topology.cores.empty() || topology.cores.size() > topology.cpus.size())
+    {
+        throw std::runtime_error("CPU topology test failed: no CPUs detected");
+    }
+    for (const xeno::pal::LogicalCpu &cpu : topology.cpus)
+    {
+        const std::vector<uint32_t> &siblings = topology.cores.at(cpu.core).cpus;
+        if (std::find(siblings.begin(), siblings.end(), cpu.id) == siblings.end() || cpu.l3 >= topology.l3Domains)
+        {
+            throw std::runtime_error("CPU topology test failed: inconsistent core or L3 mapping");
+        }
+    }
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        for (const xeno::pal::LogicalCpu &cpu : topology.cpus)
+        {
+            if (!CPU_ISSET(cpu.id, &allowed))
+            {
+                throw std::runtime_error("CPU topology test failed: CPU outside the affinity mask reported");
+            }
+        }
+    }
+#endif
+
+    // Two L3 domains of two SMT cores each; a mask keeping CPU 1 and the
+    // whole second domain drops core 0 and renumbers the rest.
+    xeno::pal::CpuTopology machine;
+    machine.cores = {{{0, 4}, 0}, {{1, 5}, 0}, {{2, 6}, 1}, {{3, 7}, 1}};
+    machine.l3Domains = 2;
+    for (uint32_t id = 0; id < 8; ++id)
+    {
+        machine.cpus.push_back({id, id % 4, 0, (id % 4) / 2});
+    }
+    xeno::pal::CpuTopology restricted = machine;
+    restricted.restrictTo({1, 2, 3, 6, 7});
+    if (restricted.cpus.size() != 5 || restricted.cores.size() != 3 || restricted.l3Domains != 2 ||
+        restricted.cores[0].cpus != std::vector<uint32_t>{1} || restricted.cores[1].cpus != std::vector<uint32_t>{2, 6} ||
+        restricted.cores[2].l3 != 1 || restricted.find(4) != nullptr || restricted.find(6)->core != 1)
+    {
+        throw std::runtime_error("CPU topology test failed: affinity mask not applied");
+    }
+    restricted = machine;
+    restricted.restrictTo({42});
+    if (restricted.cpus.size() != 8 || restricted.cores.size() != 4)
+    {
+        throw std::runtime_error("CPU topology test failed: disjoint mask emptied the topology");
+    }
+
+    xeno::pal::ThreadPoolConfig config;
+    config.workerThreads = 3;
+    config.affinity = xeno::pal::WorkerAffinity::PhysicalCores;
+    xeno::pal::ThreadPool pinned(config);
+    for (size_t i = 0; i < pinned.size(); ++i)
+    {
+        const std::vector<uint32_t> &cpus = pinned.workerAffinity(i);
+        if (cpus.empty() || cpus != topology.cores[i % topology.cores.size()].cpus)
+        {
+            throw std::runtime_error("CPU topology test failed: worker not assigned a physical core");
+        }
+    }
+
+    std::atomic<int> executed{0};
+    {
+        xeno::pal::TaskGroup group(pinned);
+        for (int i = 0; i < 256; ++i)
+        {
+            group.run([&executed]()
+                      { executed.fetch_add(1); });
+        }
+        group.wait();
+    }
+    if (executed != 256)
+    {
+        throw std::runtime_error("CPU topology test failed: pinned pool lost tasks");
+    }
+}
+
+namespace
+{
+    long parallelSum(xeno::pal::ThreadPool &pool, const std::vector<int> &values, size_t begin, size_t end)
+    {
+        if (end - begin <= 64)
+        {
+            long sum = 0;
+            for (size_t i = begin; i < end; ++i)
+            {
+                sum += values[i];
+            }
+            return sum;
+        }
+        size_t middle = begin + (end - begin) / 2;
+        long left = 0;
+        xeno::pal::TaskGroup group(pool);
+        group.run([&]()
+                  { left = parallelSum(pool, values, begin, middle); });
+        long right = parallelSum(pool, values, middle, end);
+        group.wait();
+        return left + right;
+    }
+}
+
+void test_threadpool_task_group()
+{
+    // A single worker forces nested waits to help rather than block
+    xeno::pal::ThreadPool pool(1);
+    std::vector<int> values(100000);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = static_cast<int>(i % 7);
+    }
+
+    long expected = 0;
+    for (int value : values)
+    {
+        expected += value;
+    }
+
+    xeno::pal::TaskHandle<long> total = pool.enqueue([&]()
+                                                     { return parallelSum(pool, values, 0, values.size()); });
+    if (total.get() != expected || parallelSum(pool, values, 0, values.size()) != expected)
+    {
+        throw std::runtime_error("Task group test failed: fork/join sum mismatch");
+    }
+}
+
+void test_parallel_algorithms()
+{
+    xeno::pal::ThreadPool pool(4);
+    const size_t count = 100003;
+
+    std::vector<int> hits(count, 0);
+    xeno::pal::parallelFor(pool, 0, count, [&](size_t first, size_t last)
+                           {
+        for (size_t i = first; i < last; ++i)
+        {
+            ++hits[i];
+        } });
+    for (int hit : hits)
+    {
+        if (hit != 1)
+        {
+            throw std::runtime_error("Parallel algorithm test failed: parallelFor missed or repeated an index");
+        }
+    }
+
+    std::vector<uint32_t> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = static_cast<uint32_t>((i * 2654435761u) % 1000);
+    }
+
+    uint64_t sum = xeno::pal::parallelReduce<uint64_t>(
+        pool, 0, count, 0,
+        [&](size_t first, size_t last)
+        {
+            uint64_t partial = 0;
+            for (size_t i = first; i < last; ++i)
+            {
+                partial += values[i];
+            }
+            return partial;
+        },
+        [](uint64_t a, uint64_t b)
+        { return a + b; });
+
+    std::vector<uint64_t> scanned(count);
+    xeno::pal::parallelExclusiveScan(pool, values.begin(), values.end(), scanned.begin(), uint64_t(5),
+                                     [](uint64_t a, uint64_t b)
+                                     { return a + b; });
+
+    uint64_t running = 5;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (scanned[i] != running)
+        {
+            throw std::runtime_error("Parallel algorithm test failed: exclusive scan mismatch");
+        }
+        running += values[i];
+    }
+    if (sum + 5 != running)
+    {
+        throw std::runtime_error("Parallel algorithm test failed: reduce mismatch");
+    }
+}
+
+void test_task_graph()
+{
+    xeno::pal::ThreadPool pool(3);
+    xeno::pal::TaskGraph graph(pool);
+
+    // input -> simulation -> {culling A, culling B} -> record -> submit
+    std::atomic<int> step{0};
+    std::atomic<int> order[6];
+    auto stage = [&](int slot)
+    {
+        return [&, slot]()
+        { order[slot] = step.fetch_add(1); };
+    };
+    auto input = graph.addNode("input", stage(0));
+    auto simulation = graph.addNode("simulation", stage(1));
+    auto cullA = graph.addNode("culling A", stage(2));
+    auto cullB = graph.addNode("culling B", stage(3));
+    auto record = graph.addNode("record", stage(4));
+    auto submit = graph.addNode("submit", stage(5));
+    graph.addDependency(input, simulation);
+    graph.addDependency(simulation, cullA);
+    graph.addDependency(simulation, cullB);
+    graph.addDependency(cullA, record);
+    graph.addDependency(cullB, record);
+    graph.addDependency(record, submit);
+
+    for (int frame = 0; frame < 100; ++frame)
+    {
+        step = 0;
+        graph.run();
+        if (order[0] != 0 || order[1] != 1 || order[2] < 2 || order[3] < 2 || order[2] > 3 || order[3] > 3 ||
+            order[4] != 4 || order[5] != 5)
+        {
+            throw std::runtime_error("Task graph test failed: dependency order violated");
+        }
+    }
+    if (graph.timings().size() != 6 || graph.timings()[5].startMs < graph.timings()[0].startMs)
+    {
+        throw std::runtime_error("Task graph test failed: missing node timings");
+    }
+
+    // A throwing node skips its dependents and surfaces from run()
+    xeno::pal::TaskGraph failing(pool);
+    bool dependentRan = false;
+    auto bad = failing.addNode("bad", []()
+                               { throw std::logic_error("expected"); });
+    auto after = failing.addNode("after", [&]()
+                                 { dependentRan = true; });
+    failing.addDependency(bad, after);
+    bool rethrown = false;
+    try
+    {
+        failing.run();
+    }
+    catch (const std::logic_error &)
+    {
+        rethrown = true;
+    }
+    if (!rethrown || dependentRan)
+    {
+        throw std::runtime_error("Task graph test failed: failure not propagated");
+    }
+
+    xeno::pal::TaskGraph cyclic(pool);
+    auto a = cyclic.addNode("a", []() {});
+    auto b = cyclic.addNode("b", []() {});
+    cyclic.addDependency(a, b);
+    cyclic.addDependency(b, a);
+    bool cycleDetected = false;
+    try
+    {
+        cyclic.run();
+    }
+    catch (const std::runtime_error &)
+    {
+        cycleDetected = true;
+    }
+    if (!cycleDetected)
+    {
+        throw std::runtime_error("Task graph test failed: cycle not detected");
+    }
+
+#if defined(__linux__)
+    // The caller runs out of nodes to help with while a slow one sleeps, and
+    // has to park instead of spinning. It may take the node itself, which
+    // proves nothing, so that run is repeated.
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> ranOnCaller{true};
+    xeno::pal::TaskGraph slow(pool);
+    slow.addNode("slow", [&]()
+                 {
+        ranOnCaller = std::this_thread::get_id() == caller;
+        std::this_thread::sleep_for(std::chrono::milliseconds(300)); });
+    double cpuMs = 0.0;
+    for (int attempt = 0; attempt < 5 && ranOnCaller; ++attempt)
+    {
+        double startMs = threadCpuMs();
+        slow.run();
+        cpuMs = threadCpuMs() - startMs;
+    }
+    if (cpuMs > 100.0)
+    {
+        throw std::runtime_error("Task graph test failed: waiting used " + std::to_string(cpuMs) + " ms of CPU");
+    }
+#endif
+}
+
+void test_inline_task()
+{
+    int calls = 0;
+    xeno::pal::InlineTask small([&calls]()
+                                { ++calls; });
+    xeno::pal::InlineTask moved(std::move(small));
+    if (small || !moved)
+    {
+        throw std::runtime_error("Inline task test failed: move did not transfer ownership");
+    }
+    moved();
+
+    // Too big to store inline: makeTask boxes it in pooled storage
+    struct Big
+    {
+        char payload[200];
+    } big{};
+    big.payload[199] = 7;
+    xeno::pal::InlineTask boxed = xeno::pal::makeTask([&calls, big]()
+                                                      { calls += big.payload[199]; });
+    boxed();
+    if (calls != 8)
+    {
+        throw std::runtime_error("Inline task test failed: callables not invoked");
+    }
+}
@@ -0,0 +1,172 @@
+#include "xeno-pal/xeno-pal-workqueue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    template <typename Queue>
+    bool rejectsCapacity(size_t capacity)
+    {
+        try
+        {
+            Queue queue(capacity);
+        }
+        catch (const std::runtime_error &)
+        {
+            return true;
+        }
+        return false;
+    }
+}
+
+void test_spsc_queue()
+{
+    if (!rejectsCapacity<xeno::pal::SpscQueue<int>>(0) || !rejectsCapacity<xeno::pal::SpscQueue<int>>(100))
+    {
+        throw std::runtime_error("SPSC queue test failed: capacity that is not a power of two was accepted");
+    }
+
+    // Fills to exactly capacity, then drains in order
+    xeno::pal::SpscQueue<std::unique_ptr<int>> small(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!small.tryPush(std::make_unique<int>(i)))
+        {
+            throw std::runtime_error("SPSC queue test failed: push rejected below capacity");
+        }
+    }
+    if (small.tryPush(std::make_unique<int>(4)) || small.sizeApprox() != 4)
+    {
+        throw std::runtime_error("SPSC queue test failed: push accepted past capacity");
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        std::unique_ptr<int> item;
+        if (!small.tryPop(item) || !item || *item != i)
+        {
+            throw std::runtime_error("SPSC queue test failed: items came out of order");
+        }
+    }
+    std::unique_ptr<int> none;
+    if (small.tryPop(none))
+    {
+        throw std::runtime_error("SPSC queue test failed: pop succeeded on an empty queue");
+    }
+
+    // A small ring wraps thousands of times, so any ordering bug shows up
+    // as a skipped or repeated sequence number
+    constexpr uint64_t Count = 1 << 20;
+    xeno::pal::SpscQueue<uint64_t> queue(64);
+    std::thread producer([&queue]()
+                         {
+        for (uint64_t i = 0; i < Count; ++i)
+        {
+            while (!queue.tryPush(i))
+            {
+                std::this_thread::yield();
+            }
+        } });
+
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < Count)
+    {
+        uint64_t value = 0;
+        if (!queue.tryPop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && value == expected;
+        ++expected;
+    }
+    producer.join();
+    if (!ordered)
+    {
+        throw std::runtime_error("SPSC queue test failed: consumer saw items out of order");
+    }
+}
+
+void test_mpmc_queue()
+{
+    if (!rejectsCapacity<xeno::pal::MpmcQueue<int>>(1) || !rejectsCapacity<xeno::pal::MpmcQueue<int>>(48))
+    {
+        throw std::runtime_error("MPMC queue test failed: capacity that is not a power of two was accepted");
+    }
+
+    constexpr int Producers = 4;
+    constexpr int Consumers = 4;
+    constexpr uint64_t PerProducer = 100000;
+    xeno::pal::MpmcQueue<uint64_t> queue(256);
+
+    // Every item must be popped exactly once, and each consumer must see any
+    // one producer's items in the order they were pushed
+    std::vector<std::atomic<uint8_t>> seen(Producers * PerProducer);
+    std::atomic<uint64_t> popped{0};
+    std::atomic<bool> duplicated{false};
+    std::atomic<bool> reordered{false};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < Producers; ++p)
+    {
+        threads.emplace_back([&queue, p]()
+                             {
+            for (uint64_t i = 0; i < PerProducer; ++i)
+            {
+                while (!queue.tryPush(static_cast<uint64_t>(p) * PerProducer + i))
+                {
+                    std::this_thread::yield();
+                }
+            } });
+    }
+    for (int c = 0; c < Consumers; ++c)
+    {
+        threads.emplace_back([&]()
+                             {
+            std::vector<int64_t> last(Producers, -1);
+            while (popped.load(std::memory_order_relaxed) < Producers * PerProducer)
+            {
+                uint64_t value = 0;
+                if (!queue.tryPop(value))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                popped.fetch_add(1, std::memory_order_relaxed);
+                if (seen[value].exchange(1) != 0)
+                {
+                    duplicated = true;
+                }
+                int64_t &previous = last[value / PerProducer];
+                if (static_cast<int64_t>(value % PerProducer) <= previous)
+                {
+                    reordered = true;
+                }
+                previous = static_cast<int64_t>(value % PerProducer);
+            } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    if (duplicated)
+    {
+        throw std::runtime_error("MPMC queue test failed: an item was popped twice");
+    }
+    for (const std::atomic<uint8_t> &flag : seen)
+    {
+        if (flag.load() == 0)
+        {
+            throw std::runtime_error("MPMC queue test failed: an item was lost");
+        }
+    }
+    if (reordered)
+    {
+        throw std::runtime_error("MPMC queue test failed: a producer's items were reordered");
+    }
+}
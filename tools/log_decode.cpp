@@ -0,0 +1,50 @@
+#include "xeno-pal/xeno-pal-logger.hpp"
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+// Turns a log written with LogEncoding::Binary, or any LogSink::Mapped
+// file, back into plain text:
+//
+//   xeno_log_decode game.binlog [game.log]
+//
+// Writes to stdout when no output file is given.
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::fprintf(stderr, "usage: %s <binary log> [output]\n", argv[0]);
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in)
+    {
+        std::fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+    std::ofstream file;
+    if (argc == 3)
+    {
+        file.open(argv[2]);
+        if (!file)
+        {
+            std::fprintf(stderr, "Failed to open %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    try
+    {
+        xeno::pal::binarylog::decode(in, argc == 3 ? static_cast<std::ostream &>(file) : std::cout);
+    }
+    catch (const std::exception &e)
+    {
+        // Everything before the bad entry has already been written
+        std::fprintf(stderr, "%s: %s\n", argv[1], e.what());
+        return 1;
+    }
+    return 0;
+}